@@ -3,3 +3,6 @@
 //
 
 #include "BHtree.h"
+
+template class BHtreeN<2>;
+template class BHtreeN<3>;
@@ -5,29 +5,66 @@
 #ifndef BHTREE_H
 #define BHTREE_H
 
+#include <algorithm>
+#include <cstdint>
 #include <limits>
 #include <vector>
 #include <memory>
+#include <utility>
 
+#include "Hilbert.h"
+#include "InteractionCache.h"
 #include "Node.h"
 #include "NodePool.h"
 #include "Particle.h"
+#include "ParticleMesh.h"
+#include "ParticleSpan.h"
+#include "ThreadPool.h"
 
 
-class BHtree {
+// Barnes-Hut tree over D-dimensional particles
+// D = 2: quadtree with 4 children per node, D = 3: octree with 8 children per node
+template<int D>
+class BHtreeN {
+
+public:
+    using Vec = VecN<D>;
+    using Box = BoxN<D>;
+    using Particle = ParticleN<D>;
+    using Node = NodeN<D>;
+    using NodePool = NodePoolN<D>;
+    using ParticleSpan = ParticleSpanN<D>;
 
 private:
 
-    const double G = 6.67430e-11; // Gravitational constant (adjust as needed)
+    double G = 6.67430e-11; // Gravitational constant (adjust as needed, see setGravitationalConstant)
+
+    // the particles, stored contiguously and owned by the tree
+    // empty when the tree runs on caller-owned buffers (attach)
+    std::vector<Particle> particles;
+
+    // the particle data every phase works on: a view of particles, or of caller-owned buffers
+    // nodes refer to particles by index into it, so it must only be permuted between builds
+    ParticleSpan span;
+    bool owns_particles = true;
+
+    // permutation map: permutation[slot] is the input index of the particle now stored at slot
+    // storage order changes on reorder, user-visible ids (Particle::getId) never do
+    std::vector<size_t> permutation;
+
+    // Hilbert reordering every reorder_interval builds, 0 disables it
+    int reorder_interval = 0;
+    long build_count = 0;
 
-    // the list of initial particle pointers as input
-    std::vector<std::unique_ptr<Particle>> particles;
-    // the pointers own the particles fully
+    // reorder scratch, kept between calls so a reorder only allocates the first time
+    std::vector<std::pair<uint64_t, size_t>> reorder_keys;
+    std::vector<Particle> reorder_buffer;
+    std::vector<size_t> reorder_permutation;
 
     // the initial node which will recursively expand the tree
     // Nodepool owns the root
     // BHtree does not own the root, which means must not be unique
-    Node* root;
+    Node* root = nullptr;
 
     // the pool of all free nodes
     // a pointer for strong ownership, and no need to construct initially
@@ -38,9 +75,82 @@ private:
     Box tree_bounds;
     // box has width, and corners represented by vecs
 
+    // TreePM long-range solver, nullptr runs the plain tree
+    std::unique_ptr<ParticleMeshN<D>> particleMesh;
+
+    // interaction lists reused across steps by updateTree, nullptr walks the tree every time
+    std::unique_ptr<InteractionCacheN<D>> interactionCache;
+
+    // optional pool for the per-particle sweeps, not owned, nullptr runs them serially
+    ThreadPool* threadPool = nullptr;
+    // the sweeps' loop state on the pool, kept so that parallel sweeps do not allocate
+    std::unique_ptr<ParallelLoop> parallelLoop;
+
+    // particles per sweep task: sweeps are memory bound and take large chunks
+    static constexpr size_t SWEEP_CHUNK = 16384;
+
+    // per-axis extent of a set of positions
+    struct Extent {
+        double lo[D];
+        double hi[D];
+
+        void clear() {
+            for (int k = 0; k < D; ++k) {
+                lo[k] = std::numeric_limits<double>::max();
+                hi[k] = std::numeric_limits<double>::lowest();
+            }
+        }
+        void include(const Vec& p) {
+            for (int k = 0; k < D; ++k) {
+                lo[k] = std::min(lo[k], p[k]);
+                hi[k] = std::max(hi[k], p[k]);
+            }
+        }
+        void merge(const Extent& other) {
+            for (int k = 0; k < D; ++k) {
+                lo[k] = std::min(lo[k], other.lo[k]);
+                hi[k] = std::max(hi[k], other.hi[k]);
+            }
+        }
+    };
+
+    // one partial extent per sweep chunk, reduced into extent once the sweep is done
+    std::vector<Extent> chunk_extents;
+    Extent extent;
+    // true while extent matches the current positions (set by integrate on owned particles)
+    bool extent_current = false;
 
 
 
+    static size_t chunkCount(size_t n, size_t chunk) {
+        return (n + chunk - 1) / chunk;
+    }
+
+    // Runs body(begin, end, c) for every chunk c of [0, n), on the pool when one is set.
+    // Chunk boundaries depend only on n, never on the thread count, so results do not either.
+    template<typename Body>
+    void forEachChunk(size_t n, size_t chunk, const Body& body) {
+        const size_t chunks = chunkCount(n, chunk);
+        if (!threadPool || chunks <= 1) {
+            for (size_t c = 0; c < chunks; ++c) {
+                body(c * chunk, std::min(n, (c + 1) * chunk), c);
+            }
+            return;
+        }
+        threadPool->parallelFor(*parallelLoop, chunks, [&body, n, chunk](size_t c) {
+            body(c * chunk, std::min(n, (c + 1) * chunk), c);
+        });
+    }
+
+    // the single cross-thread step of a sweep: folds the chunk extents into extent
+    void reduceExtent() {
+        extent.clear();
+        const size_t chunks = chunkCount(span.count, SWEEP_CHUNK);
+        for (size_t c = 0; c < chunks; ++c) {
+            extent.merge(chunk_extents[c]);
+        }
+    }
+
     // Children indeces vectorized -> associates particles with a location, and then associates them to a child node
     // have to check the coordinates to the quarter widths to verify their locations
     // quad: 0123, top left to br
@@ -49,58 +159,67 @@ private:
     // pre: all particles must be valid
     // post: BHtree box (bounds) set to min and max coords
     void calculateTreeBounds() {
-        if (particles.empty()) {
+        if (span.count == 0) {
             throw std::invalid_argument("BHtree::calculateBounds: particles is empty");
         }
 
-        double min_x = std::numeric_limits<double>::max();
-        double min_y = std::numeric_limits<double>::max();
-        double min_z = std::numeric_limits<double>::max();
-        double max_x = std::numeric_limits<double>::lowest();
-        double max_y = std::numeric_limits<double>::lowest();
-        double max_z = std::numeric_limits<double>::lowest();
-
-        for (const auto& p_ptr : particles) {
-            const Vec& pos = p_ptr->getPos();
-            min_x = std::min(min_x, pos.x);
-            min_y = std::min(min_y, pos.y);
-            min_z = std::min(min_z, pos.z);
-            max_x = std::max(max_x, pos.x);
-            max_y = std::max(max_y, pos.y);
-            max_z = std::max(max_z, pos.z);
+        // integrate leaves the extent of the positions it wrote, otherwise sweep them now
+        if (!extent_current) {
+            chunk_extents.resize(chunkCount(span.count, SWEEP_CHUNK));
+            forEachChunk(span.count, SWEEP_CHUNK, [this](size_t begin, size_t end, size_t c) {
+                Extent& e = chunk_extents[c];
+                e.clear();
+                for (size_t i = begin; i < end; ++i) {
+                    e.include(span.getPos(i));
+                }
+            });
+            reduceExtent();
         }
 
-        // Expand to a cubic bounding box, centered
-        double dx = max_x - min_x;
-        double dy = max_y - min_y;
-        double dz = max_z - min_z;
-        double max_dim1 = std::max(dx, dy);
-        double max_dim = std::max(max_dim1, dz);
+        Vec min_pos;
+        Vec max_pos;
+        for (int i = 0; i < D; ++i) {
+            min_pos[i] = extent.lo[i];
+            max_pos[i] = extent.hi[i];
+        }
 
+        // Expand to a cubic (square in 2D) bounding box, centered
+        double max_dim = 0.0;
+        for (int i = 0; i < D; ++i) {
+            max_dim = std::max(max_dim, max_pos[i] - min_pos[i]);
+        }
 
         // Add a small epsilon to ensure particles are strictly inside
         double padding = max_dim * 0.01;
         max_dim += padding;
 
-        Vec center = Vec((min_x + max_x) / 2.0, (min_y + max_y) / 2.0, (min_z + max_z) / 2.0);
-        tree_bounds = Box(center - Vec(max_dim / 2.0, max_dim / 2.0, max_dim / 2.0),
-                          center + Vec(max_dim / 2.0, max_dim / 2.0, max_dim / 2.0));
+        Vec center = (min_pos + max_pos) * 0.5;
+        Vec half_extent;
+        for (int i = 0; i < D; ++i) {
+            half_extent[i] = max_dim / 2.0;
+        }
+        tree_bounds = Box(center - half_extent, center + half_extent);
     }
 
 public:
 
+    // particles per force task, smaller than a sweep chunk so uneven walk costs still balance
+    // across threads (also used by Ensemble to split a member's force pass)
+    static constexpr size_t FORCE_CHUNK = 1024;
+
     // Primary constructor
     // initializes node_pool
-    // runs particles.reserve
-    BHtree(std::vector<Particle> initial_particles) // Parameter by value
+    // takes over the particle storage
+    BHtreeN(std::vector<Particle> initial_particles) // Parameter by value
     // Initialize members in the correct order and with correct syntax
-    : nodePool(std::make_unique<NodePool>(initial_particles.size() * 2))
+    : particles(std::move(initial_particles)),
+      span(Particle::spanOf(particles)),
+      nodePool(std::make_unique<NodePool>(particles.size() * 2))
     {
-        // Sets the pointer array to the length of the particles array
-        // Move the particles from the input vector directly into BHtree's unique_ptr vector
-        particles.reserve(initial_particles.size()); // Pre-allocate memory
-        for (auto& particle : initial_particles) { // Iterate over the vector passed by value
-            particles.push_back(std::make_unique<Particle>(std::move(particle))); // Move each Particle
+        // identity permutation until the first reorder
+        permutation.resize(particles.size());
+        for (size_t i = 0; i < permutation.size(); ++i) {
+            permutation[i] = i;
         }
 
         // Calculates the external-most bounds for the bounding box
@@ -112,18 +231,53 @@ public:
         // only to prepare for it.
     }
 
+    // Embedding constructor: no particles until attach() registers the caller's buffers
+    BHtreeN()
+    : nodePool(std::make_unique<NodePool>(0))
+    {
+    }
+
+    // Runs the tree directly on caller-owned buffers, no copy is made: positions and masses are
+    // read in place, the force pass writes accelerations, integrate writes positions and velocities.
+    // The tree (and its node pool) is reused across attach calls.
+    // Storage reordering is skipped in this mode, the caller's layout is never permuted.
+    // The caller may move particles between calls, so every build re-sweeps the bounds.
+    // pre: the buffers outlive their use by this tree
+    void attach(const ParticleSpan& external) {
+        if (external.count > 0 && (!external.pos || !external.mass || !external.acc)) {
+            throw std::invalid_argument("BHtree::attach: positions, masses and accelerations are required");
+        }
+        particles.clear();
+        particles.shrink_to_fit();
+        permutation.clear();
+        span = external;
+        owns_particles = false;
+        extent_current = false;
+        root = nullptr; // any tree built so far indexes the old particles
+    }
+
     void buildTree() {
-        // 1. Release all nodes from the previous tree (if any) back to the pool
-        // nodePool->resetPool(); // This should make all nodes available for reuse
-        // root.reset(); // Release ownership of the previous root node
-        //
-        // // 2. Acquire a new root node from the pool, using the calculated tree bounds
-        // root = std::unique_ptr<Node>(nodePool->acquireNode(tree_bounds));
+        // lists cached for the previous tree point into nodes about to be recycled
+        if (interactionCache) {
+            interactionCache->invalidate();
+        }
+
+        // 0. Periodically restore memory locality before the build
+        // (the bounds follow the particles every build, reordering refreshes them itself)
+        if (owns_particles && reorder_interval > 0 && build_count % reorder_interval == 0) {
+            reorderParticles();
+        } else {
+            calculateTreeBounds();
+        }
+        ++build_count;
 
-        // reset to a raw pointer instead
+        // 1. Release all nodes from the previous tree (if any) back to the pool
+        // Without this every build would take fresh nodes and the pool would grow each step;
+        // with it, builds after the first reuse the same node blocks and do not allocate.
         root = nullptr;
+        nodePool->resetPool();
 
-        // call nodePool acquireNode based on the tree bounds
+        // 2. Acquire a new root node from the pool, using the calculated tree bounds
         root = nodePool->acquireNode(tree_bounds);
 
         if (!root) {
@@ -131,43 +285,244 @@ public:
         }
 
         // 3. Insert all particles into the tree (this recursively builds the tree)
-        for (const auto& p_ptr : particles) {
-            // IMPORTANT: The Node::insertParticle method should handle the recursive subdivision
-            // and placement of particles.
-            root->addParticle(p_ptr.get(), *nodePool); // Renamed `addParticle` from `insertParticle` in Node
+        try {
+            for (size_t i = 0; i < span.count; ++i) {
+                // IMPORTANT: The Node::insertParticle method should handle the recursive subdivision
+                // and placement of particles.
+                root->addParticle(i, span.getPos(i), span.getMass(i), *nodePool); // Renamed `addParticle` from `insertParticle` in Node
+            }
+        } catch (...) {
+            // a half-built tree must not be walked
+            root = nullptr;
+            throw;
+        }
+
+        // 4. TreePM: the long-range potential is solved once per build, before any force range
+        if (particleMesh) {
+            particleMesh->solve(span, tree_bounds, G);
+        }
+    }
+
+    // Brings the tree up to date with the current positions before a force pass at theta.
+    // With interaction caching on, the existing tree is kept while every particle stays within
+    // the drift margin of its cached lists: only the node moments are refit (and the mesh
+    // re-solved under TreePM). Otherwise, or once a particle drifts too far, this is buildTree
+    // followed by a fresh set of lists.
+    void updateTree(double theta) {
+        if (interactionCache && root && interactionCache->isValidFor(theta)
+            && interactionCache->withinMargin(span)) {
+            root->refit(span);
+            if (!particleMesh) {
+                return;
+            }
+            calculateTreeBounds();
+            particleMesh->solve(span, tree_bounds, G);
+            if (interactionCache->coversCutoff(particleMesh->getCutoffRadius())) {
+                return;
+            }
+            // the mesh spacing grew past what the lists allow for, fall through to a rebuild
+        }
+
+        buildTree();
+        if (interactionCache) {
+            interactionCache->build(root, span, theta, particleMesh ? particleMesh->getCutoffRadius() : 0.0);
         }
     }
 
     // recursive calculation of force for all particles in the tree
+    // Writes the acceleration of every particle (F / m, which is what the buffers hold).
+    // Runs in chunks on the thread pool when one is set.
     void calculateForces(double theta) {
-        // 1. Reset accumulated forces/accelerations for all particles
-        for (auto& p_ptr : particles) {
-            p_ptr->resetAccumulatedForce();
+        forEachChunk(span.count, FORCE_CHUNK, [this, theta](size_t begin, size_t end, size_t) {
+            calculateForces(theta, begin, end);
+        });
+    }
+
+    // force calculation for the storage slots [begin, end) only
+    // the tree is read-only here, so disjoint ranges may run concurrently
+    void calculateForces(double theta, size_t begin, size_t end) {
+        end = std::min(end, span.count);
+        const bool cached = root && interactionCache && interactionCache->isValidFor(theta);
+
+        // For each particle, traverse the tree and write the summed acceleration once
+        // (no tree yet leaves the accelerations at zero)
+        for (size_t i = begin; i < end; ++i) {
+            const Vec pos = span.getPos(i);
+            Vec acc;
+            if (root && particleMesh) {
+                // TreePM: mesh long-range plus tree short-range within the cutoff
+                acc = particleMesh->accelerationAt(pos);
+                if (cached) {
+                    interactionCache->accumulate(i, pos, span, G, particleMesh->getSplitRadius(),
+                                                 particleMesh->getCutoffRadius(), acc);
+                } else {
+                    root->calculateShortRangeAccelerationOn(i, pos, theta, G, particleMesh->getSplitRadius(),
+                                                            particleMesh->getCutoffRadius(), acc);
+                }
+            } else if (cached) {
+                interactionCache->accumulate(i, pos, span, G, 0.0, 0.0, acc);
+            } else if (root) {
+                root->calculateAccelerationOn(i, pos, theta, G, acc); // Pass G for force calculation
+            }
+            span.setAcc(i, acc);
+        }
+    }
+
+    // Switches to the TreePM solver: a mesh of mesh_cells per side (power of two) carries the
+    // long-range force, split at split_cells mesh cells, and the tree walk stops at
+    // cutoff_splits split radii. Takes effect at the next buildTree.
+    void enableTreePM(int mesh_cells, double split_cells = 1.25, double cutoff_splits = 4.5) {
+        particleMesh = std::make_unique<ParticleMeshN<D>>(mesh_cells, split_cells, cutoff_splits);
+        root = nullptr; // the current tree has no mesh solve to go with it
+        if (interactionCache) {
+            interactionCache->invalidate();
+        }
+    }
+
+    // Back to the plain tree walk
+    void disableTreePM() {
+        particleMesh.reset();
+        // cached lists were cut off at the short-range radius
+        if (interactionCache) {
+            interactionCache->invalidate();
+        }
+    }
+
+    // Lets updateTree keep the tree between steps while particles move little, see InteractionCache.
+    // group_size bounds the particles sharing one list. Takes effect at the next updateTree.
+    void enableInteractionCaching(size_t group_size = 8) {
+        interactionCache = std::make_unique<InteractionCacheN<D>>(group_size);
+    }
+
+    // Back to a full build and walk every step
+    void disableInteractionCaching() {
+        interactionCache.reset();
+    }
+
+    // Update particle positions and velocities based on calculated forces
+    // Euler-Cromer, as Particle::update; the accelerations are left in place for the caller.
+    // Kick, drift and the extent of the new positions happen in one sweep, so the next build
+    // gets its bounds without reading the positions again.
+    void integrate(double dt) {
+        if (span.count > 0 && !span.vel) {
+            throw std::invalid_argument("BHtree::integrate: no velocity buffer attached");
+        }
+        chunk_extents.resize(chunkCount(span.count, SWEEP_CHUNK));
+        forEachChunk(span.count, SWEEP_CHUNK, [this, dt](size_t begin, size_t end, size_t c) {
+            Extent& e = chunk_extents[c];
+            e.clear();
+            for (size_t i = begin; i < end; ++i) {
+                Vec vel = span.getVel(i) + span.getAcc(i) * dt;
+                Vec pos = span.getPos(i) + vel * dt;
+                span.setVel(i, vel);
+                span.setPos(i, pos);
+                e.include(pos);
+            }
+        });
+        reduceExtent();
+        // attached buffers may still be edited by the caller before the next build
+        extent_current = owns_particles;
+    }
+
+    // Permutes the particle storage into Hilbert-curve order, so that particles
+    // visited consecutively by the force loop and integrator sit next to each other
+    // in memory and share the tree nodes they touch.
+    // pre: no tree built on the current storage is used afterwards (call buildTree again)
+    // post: particles sorted by Hilbert key, permutation updated to match
+    void reorderParticles() {
+        if (!owns_particles) {
+            throw std::logic_error("BHtree::reorderParticles: attached buffers are never permuted");
         }
 
-        // 2. For each particle, traverse the tree to calculate its total force
-        for (auto& p_ptr : particles) {
-            if (root) {
-                root->calculateForceOn(p_ptr.get(), theta, G); // Pass G for force calculation
+        // keys need bounds that enclose the current positions
+        calculateTreeBounds();
+
+        const size_t n = particles.size();
+        reorder_keys.resize(n);
+        forEachChunk(n, SWEEP_CHUNK, [this](size_t begin, size_t end, size_t) {
+            for (size_t i = begin; i < end; ++i) {
+                reorder_keys[i] = {hilbertKey<D>(span.getPos(i), tree_bounds), i};
             }
+        });
+        std::sort(reorder_keys.begin(), reorder_keys.end());
+
+        reorder_buffer.clear();
+        reorder_buffer.reserve(n);
+        reorder_permutation.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            size_t src = reorder_keys[i].second;
+            reorder_buffer.push_back(std::move(particles[src]));
+            reorder_permutation[i] = permutation[src];
+        }
+        particles.swap(reorder_buffer);
+        permutation.swap(reorder_permutation);
+        span = Particle::spanOf(particles);
+
+        // the old tree points at the previous layout
+        root = nullptr;
+    }
+
+    // Enables reordering at the start of every k-th build, k <= 0 disables it
+    void setReorderInterval(int k) {
+        reorder_interval = std::max(k, 0);
+    }
+
+    void setGravitationalConstant(double g) {
+        G = g;
+    }
+
+    // Spreads the bounds, key, force and integration sweeps over pool; nullptr runs them serially.
+    // The tree build itself stays serial. The pool is not owned and must outlive its use here.
+    void setThreadPool(ThreadPool* pool) {
+        threadPool = pool;
+        if (pool && !parallelLoop) {
+            parallelLoop = std::make_unique<ParallelLoop>();
         }
     }
 
+    // --- Getters ---
+    size_t size() const {
+        return span.count;
+    }
+    bool isBuilt() const {
+        return root != nullptr;
+    }
+    double getGravitationalConstant() const {
+        return G;
+    }
+    // owned particles, empty when attached to external buffers
+    const std::vector<Particle>& getParticles() const {
+        return particles;
+    }
+    const ParticleSpan& getSpan() const {
+        return span;
+    }
+    // input index of the particle stored at slot (identity for attached buffers)
+    size_t getOriginalIndex(size_t slot) const {
+        return permutation.empty() ? slot : permutation[slot];
+    }
+    // full builds so far, refits by updateTree under interaction caching are not counted
+    long getBuildCount() const {
+        return build_count;
+    }
+
+    // After the first step the node pool and scratch buffers are sized, and later steps do
+    // not allocate (checked by tests/AllocationTest.cpp).
     void step(double dt, double theta) {
-        // 1. Build the tree for the current particle distribution
-        buildTree();
+        // 1. Build (or refit, with interaction caching) the tree for the current particle distribution
+        updateTree(theta);
 
         // 2. Calculate forces on all particles using the built tree
         calculateForces(theta);
 
         // 3. Update particle positions and velocities based on calculated forces
-        for (auto& p_ptr : particles) {
-            p_ptr->update(dt); // Particle::update should take dt and update pos/vel based on acc_force
-        }
+        integrate(dt);
     }
 
 };
 
-
+using Quadtree = BHtreeN<2>;
+using Octree = BHtreeN<3>;
+using BHtree = Octree; // the default 3D build
 
 #endif //BHTREE_H
@@ -0,0 +1,213 @@
+//
+// Created by sailsec on 10/19/26.
+//
+
+#include "BHtreeCApi.h"
+
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "BHtree.h"
+#include "ThreadPool.h"
+
+// The opaque handle: exactly one of the trees is set, matching dimensions
+struct bh_tree {
+    int dimensions = 0;
+    std::unique_ptr<ThreadPool> pool; // bh_set_threads, declared first so it outlives the trees
+    std::unique_ptr<BHtreeN<2>> tree2;
+    std::unique_ptr<BHtreeN<3>> tree3;
+    bool has_particles = false;
+    std::string last_error;
+};
+
+namespace {
+
+// Runs op on the tree of the right dimension and turns exceptions into status codes,
+// nothing may propagate across the C boundary.
+template<typename Op>
+bh_status guarded(bh_tree* tree, Op&& op) {
+    if (tree == nullptr) {
+        return BH_ERROR_INVALID_ARGUMENT;
+    }
+    tree->last_error.clear();
+    try {
+        if (tree->dimensions == 2) {
+            return op(*tree->tree2);
+        }
+        return op(*tree->tree3);
+    } catch (const std::invalid_argument& e) {
+        tree->last_error = e.what();
+        return BH_ERROR_INVALID_ARGUMENT;
+    } catch (const std::logic_error& e) {
+        tree->last_error = e.what();
+        return BH_ERROR_STATE;
+    } catch (const std::exception& e) {
+        tree->last_error = e.what();
+        return BH_ERROR_RUNTIME;
+    } catch (...) {
+        tree->last_error = "unknown error";
+        return BH_ERROR_RUNTIME;
+    }
+}
+
+bool validBuffer(const double* base, size_t stride) {
+    return base != nullptr && stride % sizeof(double) == 0
+           && reinterpret_cast<uintptr_t>(base) % alignof(double) == 0;
+}
+
+// Vector fields need a full record per particle: overlapping records would make every
+// particle coincide (positions) or have concurrent chunks write the same record (outputs).
+bool validVectorBuffer(const double* base, size_t stride, int dimensions) {
+    return validBuffer(base, stride) && stride >= dimensions * sizeof(double);
+}
+
+} // namespace
+
+extern "C" {
+
+bh_tree* bh_create(int dimensions) {
+    if (dimensions != 2 && dimensions != 3) {
+        return nullptr;
+    }
+    try {
+        auto tree = std::make_unique<bh_tree>();
+        tree->dimensions = dimensions;
+        if (dimensions == 2) {
+            tree->tree2 = std::make_unique<BHtreeN<2>>();
+        } else {
+            tree->tree3 = std::make_unique<BHtreeN<3>>();
+        }
+        return tree.release();
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void bh_destroy(bh_tree* tree) {
+    delete tree;
+}
+
+bh_status bh_set_particles(bh_tree* tree, size_t count,
+                           double* positions, size_t position_stride,
+                           const double* masses, size_t mass_stride,
+                           double* accelerations, size_t acceleration_stride) {
+    return guarded(tree, [&](auto& t) {
+        if (count == 0 || !validVectorBuffer(positions, position_stride, tree->dimensions)
+            || !validBuffer(masses, mass_stride)
+            || !validVectorBuffer(accelerations, acceleration_stride, tree->dimensions)) {
+            throw std::invalid_argument("bh_set_particles: null, misaligned or overlapping buffer, or zero count");
+        }
+        typename std::remove_reference_t<decltype(t)>::ParticleSpan span;
+        span.count = count;
+        span.pos = positions;
+        span.pos_stride = position_stride;
+        span.mass = masses;
+        span.mass_stride = mass_stride;
+        span.acc = accelerations;
+        span.acc_stride = acceleration_stride;
+        t.attach(span);
+        tree->has_particles = true;
+        return BH_OK;
+    });
+}
+
+bh_status bh_set_velocities(bh_tree* tree, double* velocities, size_t velocity_stride) {
+    return guarded(tree, [&](auto& t) {
+        if (!tree->has_particles) {
+            throw std::logic_error("bh_set_velocities: call bh_set_particles first");
+        }
+        if (!validVectorBuffer(velocities, velocity_stride, tree->dimensions)) {
+            throw std::invalid_argument("bh_set_velocities: null, misaligned or overlapping buffer");
+        }
+        auto span = t.getSpan();
+        span.vel = velocities;
+        span.vel_stride = velocity_stride;
+        t.attach(span);
+        return BH_OK;
+    });
+}
+
+bh_status bh_set_gravitational_constant(bh_tree* tree, double g) {
+    return guarded(tree, [&](auto& t) {
+        t.setGravitationalConstant(g);
+        return BH_OK;
+    });
+}
+
+bh_status bh_set_treepm(bh_tree* tree, int mesh_cells, double split_cells, double cutoff_splits) {
+    return guarded(tree, [&](auto& t) {
+        if (mesh_cells == 0) {
+            t.disableTreePM();
+        } else {
+            t.enableTreePM(mesh_cells, split_cells > 0.0 ? split_cells : 1.25,
+                           cutoff_splits > 0.0 ? cutoff_splits : 4.5);
+        }
+        return BH_OK;
+    });
+}
+
+bh_status bh_set_interaction_caching(bh_tree* tree, size_t group_size) {
+    return guarded(tree, [&](auto& t) {
+        if (group_size == 0) {
+            t.disableInteractionCaching();
+        } else {
+            t.enableInteractionCaching(group_size);
+        }
+        return BH_OK;
+    });
+}
+
+bh_status bh_set_threads(bh_tree* tree, size_t num_threads) {
+    return guarded(tree, [&](auto& t) {
+        t.setThreadPool(nullptr);
+        tree->pool.reset();
+        if (num_threads != 1) {
+            tree->pool = std::make_unique<ThreadPool>(num_threads);
+            t.setThreadPool(tree->pool.get());
+        }
+        return BH_OK;
+    });
+}
+
+bh_status bh_build(bh_tree* tree) {
+    return guarded(tree, [&](auto& t) {
+        if (!tree->has_particles) {
+            throw std::logic_error("bh_build: no particles registered");
+        }
+        t.buildTree();
+        return BH_OK;
+    });
+}
+
+bh_status bh_forces(bh_tree* tree, double theta) {
+    return guarded(tree, [&](auto& t) {
+        if (!t.isBuilt()) {
+            throw std::logic_error("bh_forces: no tree built, call bh_build first");
+        }
+        t.calculateForces(theta);
+        return BH_OK;
+    });
+}
+
+bh_status bh_step(bh_tree* tree, double dt, double theta) {
+    return guarded(tree, [&](auto& t) {
+        if (!tree->has_particles) {
+            throw std::logic_error("bh_step: no particles registered");
+        }
+        if (!t.getSpan().vel) {
+            throw std::logic_error("bh_step: no velocities registered");
+        }
+        t.step(dt, theta);
+        return BH_OK;
+    });
+}
+
+const char* bh_last_error(const bh_tree* tree) {
+    return tree ? tree->last_error.c_str() : "";
+}
+
+} // extern "C"
@@ -0,0 +1,93 @@
+/*
+ * Created by sailsec on 10/19/26.
+ *
+ * Stable C interface to the BHtree gravity engine, built as the bhtree shared library.
+ *
+ * The caller keeps ownership of all particle data. Buffers are registered once with a base
+ * pointer and a byte stride per field, and every call then reads and writes them in place:
+ * positions and masses are read, bh_forces writes accelerations, bh_step also advances
+ * positions and velocities. Nothing is copied, and the tree with its node pool is kept
+ * between calls, so after the first build a step does not allocate.
+ *
+ * Vectors are `dimensions` consecutive doubles (x, y[, z]), and their strides must be at least
+ * dimensions * sizeof(double). Masses may use a stride of 0, which repeats the first record,
+ * e.g. one mass shared by every particle.
+ */
+
+#ifndef BHTREECAPI_H
+#define BHTREECAPI_H
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+#  if defined(BHTREE_BUILDING_LIBRARY)
+#    define BHTREE_API __declspec(dllexport)
+#  else
+#    define BHTREE_API __declspec(dllimport)
+#  endif
+#else
+#  define BHTREE_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct bh_tree bh_tree;
+
+typedef enum bh_status {
+    BH_OK = 0,
+    BH_ERROR_INVALID_ARGUMENT = 1, /* bad pointer, stride, size or parameter */
+    BH_ERROR_STATE = 2,            /* call out of order, e.g. forces before any build */
+    BH_ERROR_RUNTIME = 3           /* engine failure, see bh_last_error */
+} bh_status;
+
+/* Creates an empty tree for dimensions 2 (quadtree) or 3 (octree). Returns NULL otherwise. */
+BHTREE_API bh_tree* bh_create(int dimensions);
+BHTREE_API void bh_destroy(bh_tree* tree);
+
+/* Registers the particle buffers. Strides are in bytes and must be multiples of sizeof(double).
+ * Particles at identical positions cannot be separated by the tree, bh_build reports them
+ * as BH_ERROR_RUNTIME.
+ * Replaces any previous registration and invalidates the current tree. */
+BHTREE_API bh_status bh_set_particles(bh_tree* tree, size_t count,
+                                      double* positions, size_t position_stride,
+                                      const double* masses, size_t mass_stride,
+                                      double* accelerations, size_t acceleration_stride);
+
+/* Registers velocities, required by bh_step only. Call after bh_set_particles.
+ * Like bh_set_particles, it invalidates the current tree. */
+BHTREE_API bh_status bh_set_velocities(bh_tree* tree, double* velocities, size_t velocity_stride);
+
+/* Gravitational constant in the caller's units (default 6.67430e-11). */
+BHTREE_API bh_status bh_set_gravitational_constant(bh_tree* tree, double g);
+
+/* Enables the TreePM solver with mesh_cells per side (a power of two, at least 8);
+ * split_cells and cutoff_splits <= 0 select the defaults. mesh_cells == 0 disables it. */
+BHTREE_API bh_status bh_set_treepm(bh_tree* tree, int mesh_cells, double split_cells, double cutoff_splits);
+
+/* Lets bh_step keep the tree between steps while particles move little, walking cached
+ * interaction lists of up to group_size particles each instead. group_size == 0 disables it. */
+BHTREE_API bh_status bh_set_interaction_caching(bh_tree* tree, size_t group_size);
+
+/* Runs the per-particle sweeps (bounds, forces, integration) on num_threads threads owned by
+ * tree, 0 means one per hardware thread. num_threads == 1 runs them on the calling thread. */
+BHTREE_API bh_status bh_set_threads(bh_tree* tree, size_t num_threads);
+
+/* Builds the tree from the current positions. */
+BHTREE_API bh_status bh_build(bh_tree* tree);
+
+/* Writes accelerations using the last build. May be called repeatedly on the same tree. */
+BHTREE_API bh_status bh_forces(bh_tree* tree, double theta);
+
+/* Build (or refit, with interaction caching), forces, then one Euler-Cromer step of dt on positions and velocities. */
+BHTREE_API bh_status bh_step(bh_tree* tree, double dt, double theta);
+
+/* Message of the last failed call on tree, "" if none. Valid until the next call. */
+BHTREE_API const char* bh_last_error(const bh_tree* tree);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BHTREECAPI_H */
@@ -3,3 +3,6 @@
 //
 
 #include "Box.h"
+
+template struct BoxN<2>;
+template struct BoxN<3>;
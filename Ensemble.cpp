@@ -0,0 +1,103 @@
+//
+// Created by sailsec on 10/19/26.
+//
+
+#include "Ensemble.h"
+
+#include <algorithm>
+#include <chrono>
+
+template<int D>
+EnsembleN<D>::EnsembleN(size_t num_threads)
+    : pool(std::make_unique<ThreadPool>(num_threads)) {
+}
+
+template<int D>
+size_t EnsembleN<D>::addSimulation(std::vector<ParticleN<D>> initial_particles) {
+    auto member = std::make_unique<Member>();
+    member->tree = std::make_unique<BHtreeN<D>>(std::move(initial_particles));
+    // a large member's integrate and bounds sweeps fan out on the same pool
+    member->tree->setThreadPool(pool.get());
+    members.push_back(std::move(member));
+    return members.size() - 1;
+}
+
+template<int D>
+void EnsembleN<D>::scheduleBuild(Member& m) {
+    pool->submit(*run_group, [this, &m] {
+        m.tree->updateTree(run_theta);
+        scheduleForces(m);
+    });
+}
+
+template<int D>
+void EnsembleN<D>::scheduleForces(Member& m) {
+    // larger members are split into force chunks, so idle workers can steal part of them
+    constexpr size_t FORCE_CHUNK = BHtreeN<D>::FORCE_CHUNK;
+    const size_t n = m.tree->size();
+    const size_t chunks = std::max<size_t>(1, (n + FORCE_CHUNK - 1) / FORCE_CHUNK);
+
+    // set before any chunk can finish
+    m.force_chunks_left.store(chunks);
+    for (size_t c = 0; c < chunks; ++c) {
+        size_t begin = c * FORCE_CHUNK;
+        size_t end = std::min(n, begin + FORCE_CHUNK);
+        pool->submit(*run_group, [this, &m, begin, end] {
+            m.tree->calculateForces(run_theta, begin, end);
+            // the last chunk to finish moves the member on
+            if (m.force_chunks_left.fetch_sub(1) == 1) {
+                scheduleIntegrate(m);
+            }
+        });
+    }
+}
+
+template<int D>
+void EnsembleN<D>::scheduleIntegrate(Member& m) {
+    pool->submit(*run_group, [this, &m] {
+        m.tree->integrate(run_dt);
+        if (--m.steps_left > 0) {
+            scheduleBuild(m);
+        }
+    });
+}
+
+template<int D>
+EnsembleStats EnsembleN<D>::run(int num_steps, double dt, double theta) {
+    EnsembleStats stats;
+    if (num_steps <= 0 || members.empty()) {
+        return stats;
+    }
+
+    TaskGroup group;
+    run_group = &group;
+    run_dt = dt;
+    run_theta = theta;
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto& m : members) {
+        m->steps_left = num_steps;
+        scheduleBuild(*m);
+    }
+    try {
+        pool->wait(group);
+    } catch (...) {
+        run_group = nullptr;
+        throw;
+    }
+    auto end = std::chrono::steady_clock::now();
+    run_group = nullptr;
+
+    stats.wall_seconds = std::chrono::duration<double>(end - start).count();
+    for (const auto& m : members) {
+        stats.simulation_steps += num_steps;
+        stats.particle_steps += static_cast<long>(m->tree->size()) * num_steps;
+    }
+    if (stats.wall_seconds > 0.0) {
+        stats.particle_steps_per_second = stats.particle_steps / stats.wall_seconds;
+    }
+    return stats;
+}
+
+template class EnsembleN<2>;
+template class EnsembleN<3>;
@@ -0,0 +1,81 @@
+//
+// Created by sailsec on 10/19/26.
+//
+
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "BHtree.h"
+#include "Particle.h"
+#include "ThreadPool.h"
+
+// Aggregate throughput of one Ensemble::run
+struct EnsembleStats {
+    double wall_seconds = 0.0;          // elapsed time of the whole run
+    long simulation_steps = 0;          // steps summed over all members
+    long particle_steps = 0;            // particles advanced by one step, summed over all members
+    double particle_steps_per_second = 0.0;
+};
+
+// Runs many independent BHtree simulations (parameter sweeps, seed ensembles) on one
+// shared work-stealing pool. Each member keeps its own particles and NodePool; their
+// build, force and integrate phases are scheduled as tasks, so small simulations that
+// cannot fill the machine on their own are interleaved until every core is busy.
+// All members share the dimension D.
+template<int D>
+class EnsembleN {
+
+private:
+    // per-member scheduling state
+    struct Member {
+        std::unique_ptr<BHtreeN<D>> tree;
+        int steps_left = 0;
+        std::atomic<size_t> force_chunks_left{0};
+    };
+
+    std::unique_ptr<ThreadPool> pool;
+    std::vector<std::unique_ptr<Member>> members;
+
+    // parameters of the run in progress
+    TaskGroup* run_group = nullptr;
+    double run_dt = 0.0;
+    double run_theta = 0.0;
+
+    // each phase submits the next one when it finishes
+    void scheduleBuild(Member& m);
+    void scheduleForces(Member& m);
+    void scheduleIntegrate(Member& m);
+
+public:
+    // num_threads == 0 uses one worker per hardware thread
+    explicit EnsembleN(size_t num_threads = 0);
+
+    // Adds a simulation, returns its index
+    size_t addSimulation(std::vector<ParticleN<D>> initial_particles);
+
+    // --- Getters ---
+    size_t size() const {
+        return members.size();
+    }
+    BHtreeN<D>& getSimulation(size_t index) {
+        return *members.at(index)->tree;
+    }
+    size_t getThreadCount() const {
+        return pool->getThreadCount();
+    }
+
+    // Advances every member by num_steps steps of dt.
+    // Members progress independently; the call returns once all of them are done.
+    // post: rethrows the first exception raised by any member
+    EnsembleStats run(int num_steps, double dt, double theta);
+};
+
+using Ensemble2 = EnsembleN<2>;
+using Ensemble3 = EnsembleN<3>;
+using Ensemble = Ensemble3; // the default 3D build
+
+#endif //ENSEMBLE_H
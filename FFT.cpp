@@ -0,0 +1,91 @@
+//
+// Created by sailsec on 10/19/26.
+//
+
+#include "FFT.h"
+
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+#include <utility>
+
+FFT::FFT(size_t length) : n(length) {
+    if (n == 0 || (n & (n - 1)) != 0) {
+        throw std::invalid_argument("FFT: length must be a power of two");
+    }
+
+    twiddles.resize(n / 2);
+    for (size_t k = 0; k < n / 2; ++k) {
+        double angle = -2.0 * std::numbers::pi * static_cast<double>(k) / static_cast<double>(n);
+        twiddles[k] = std::polar(1.0, angle);
+    }
+
+    int log_n = 0;
+    while ((size_t(1) << log_n) < n) {
+        ++log_n;
+    }
+    bit_reverse.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        size_t r = 0;
+        for (int b = 0; b < log_n; ++b) {
+            r |= ((i >> b) & 1) << (log_n - 1 - b);
+        }
+        bit_reverse[i] = r;
+    }
+
+    line.resize(n);
+}
+
+void FFT::transform(std::complex<double>* data, bool inverse) {
+    for (size_t i = 0; i < n; ++i) {
+        if (i < bit_reverse[i]) {
+            std::swap(data[i], data[bit_reverse[i]]);
+        }
+    }
+
+    // iterative Cooley-Tukey butterflies
+    for (size_t len = 2; len <= n; len <<= 1) {
+        size_t half = len / 2;
+        size_t step = n / len;
+        for (size_t start = 0; start < n; start += len) {
+            for (size_t k = 0; k < half; ++k) {
+                std::complex<double> w = inverse ? std::conj(twiddles[k * step]) : twiddles[k * step];
+                std::complex<double> u = data[start + k];
+                std::complex<double> v = data[start + k + half] * w;
+                data[start + k] = u + v;
+                data[start + k + half] = u - v;
+            }
+        }
+    }
+
+    if (inverse) {
+        const double scale = 1.0 / static_cast<double>(n);
+        for (size_t i = 0; i < n; ++i) {
+            data[i] *= scale;
+        }
+    }
+}
+
+void FFT::transformGrid(std::complex<double>* grid, int dimensions, bool inverse) {
+    size_t total = 1;
+    for (int d = 0; d < dimensions; ++d) {
+        total *= n;
+    }
+
+    // axis d has stride n^(dimensions - 1 - d) in row-major order
+    for (size_t stride = 1; stride < total; stride *= n) {
+        const size_t block = stride * n;
+        for (size_t outer = 0; outer < total; outer += block) {
+            for (size_t inner = 0; inner < stride; ++inner) {
+                std::complex<double>* first = grid + outer + inner;
+                for (size_t i = 0; i < n; ++i) {
+                    line[i] = first[i * stride];
+                }
+                transform(line.data(), inverse);
+                for (size_t i = 0; i < n; ++i) {
+                    first[i * stride] = line[i];
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,38 @@
+//
+// Created by sailsec on 10/19/26.
+//
+
+#ifndef FFT_H
+#define FFT_H
+
+#include <complex>
+#include <vector>
+
+// Self-contained radix-2 complex FFT for the particle-mesh solver.
+// One instance transforms lines of a fixed power-of-two length n, and whole
+// D-dimensional n^D grids (row-major) one axis at a time.
+class FFT {
+
+private:
+    size_t n;
+    std::vector<std::complex<double>> twiddles; // e^(-2 pi i k / n), k < n / 2
+    std::vector<size_t> bit_reverse;            // input permutation of the iterative butterfly
+    std::vector<std::complex<double>> line;     // scratch for one strided grid line
+
+public:
+    // pre: length must be a power of two
+    explicit FFT(size_t length);
+
+    size_t size() const {
+        return n;
+    }
+
+    // In-place transform of n contiguous values.
+    // The inverse transform includes the 1/n normalization.
+    void transform(std::complex<double>* data, bool inverse);
+
+    // In-place transform of an n^D row-major grid along every axis.
+    void transformGrid(std::complex<double>* grid, int dimensions, bool inverse);
+};
+
+#endif //FFT_H
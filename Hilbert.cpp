@@ -0,0 +1,67 @@
+//
+// Created by sailsec on 10/19/26.
+//
+
+#include "Hilbert.h"
+
+#include <algorithm>
+
+// Maps a coordinate onto the integer grid [0, 2^bits - 1] along one axis.
+static uint32_t quantize(double value, double min, double side, int bits) {
+    const double cells = static_cast<double>((1u << bits) - 1);
+    double scaled = (side > 0.0) ? (value - min) / side * cells : 0.0;
+    scaled = std::clamp(scaled, 0.0, cells);
+    return static_cast<uint32_t>(scaled);
+}
+
+template<int D>
+uint64_t hilbertKey(const VecN<D>& point, const BoxN<D>& bounds) {
+    constexpr int bits = HILBERT_BITS<D>;
+    const double side = bounds.getSideLength();
+    uint32_t X[D];
+    for (int i = 0; i < D; ++i) {
+        X[i] = quantize(point[i], bounds.min[i], side, bits);
+    }
+    const int n = D;
+
+    // Skilling's axes-to-transpose: rotate/reflect each level into curve orientation
+    const uint32_t M = 1u << (bits - 1);
+    for (uint32_t Q = M; Q > 1; Q >>= 1) {
+        uint32_t P = Q - 1;
+        for (int i = 0; i < n; ++i) {
+            if (X[i] & Q) {
+                X[0] ^= P; // invert low bits of the first axis
+            } else {
+                uint32_t t = (X[0] ^ X[i]) & P; // exchange low bits with the first axis
+                X[0] ^= t;
+                X[i] ^= t;
+            }
+        }
+    }
+
+    // Gray encode
+    for (int i = 1; i < n; ++i) {
+        X[i] ^= X[i - 1];
+    }
+    uint32_t t = 0;
+    for (uint32_t Q = M; Q > 1; Q >>= 1) {
+        if (X[n - 1] & Q) {
+            t ^= Q - 1;
+        }
+    }
+    for (int i = 0; i < n; ++i) {
+        X[i] ^= t;
+    }
+
+    // Interleave the transposed bits, most significant level first
+    uint64_t key = 0;
+    for (int bit = bits - 1; bit >= 0; --bit) {
+        for (int i = 0; i < n; ++i) {
+            key = (key << 1) | ((X[i] >> bit) & 1u);
+        }
+    }
+    return key;
+}
+
+template uint64_t hilbertKey<2>(const VecN<2>& point, const BoxN<2>& bounds);
+template uint64_t hilbertKey<3>(const VecN<3>& point, const BoxN<3>& bounds);
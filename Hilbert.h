@@ -0,0 +1,27 @@
+//
+// Created by sailsec on 10/19/26.
+//
+
+#ifndef HILBERT_H
+#define HILBERT_H
+
+#include <cstdint>
+
+#include "Box.h"
+#include "Vec.h"
+
+// Hilbert space-filling curve keys used to reorder particle storage.
+// Particles that are close along the curve are close in space, so sorting
+// the particle array by key makes each tree walk touch neighbouring memory.
+
+// bits of resolution per axis, D * bits <= 63 fits in one uint64_t key
+// 3D: 21 bits per axis, 2D: 31 bits per axis
+template<int D>
+constexpr int HILBERT_BITS = 63 / D;
+
+// pre: bounds must enclose point (points outside are clamped to the edge)
+// post: returns the position of point along the Hilbert curve through bounds
+template<int D>
+uint64_t hilbertKey(const VecN<D>& point, const BoxN<D>& bounds);
+
+#endif //HILBERT_H
@@ -0,0 +1,228 @@
+//
+// Created by sailsec on 10/19/26.
+//
+
+#include "InteractionCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+template<int D>
+InteractionCacheN<D>::InteractionCacheN(size_t group_size)
+    : group_size(group_size) {
+    if (group_size == 0) {
+        throw std::invalid_argument("InteractionCache: group_size must be positive");
+    }
+}
+
+template<int D>
+size_t InteractionCacheN<D>::numberSubtree(const NodeN<D>* node) {
+    const size_t number = subtree_size.size();
+    subtree_size.push_back(1);
+    size_t size = 1;
+    for (int c = 0; c < NodeN<D>::NUM_CHILDREN; ++c) {
+        const NodeN<D>* child = node->getChild(c);
+        if (child != nullptr && !child->isEmpty()) {
+            size += numberSubtree(child);
+        }
+    }
+    subtree_size[number] = size;
+    return size;
+}
+
+template<int D>
+void InteractionCacheN<D>::findGroups(const NodeN<D>* node) {
+    if (node == nullptr || node->isEmpty()) {
+        return;
+    }
+    if (node->getParticleCount() <= group_size || node->getParticleIndex() != NodeN<D>::NO_PARTICLE) {
+        group_roots.push_back(node);
+        return;
+    }
+    for (int c = 0; c < NodeN<D>::NUM_CHILDREN; ++c) {
+        findGroups(node->getChild(c));
+    }
+}
+
+template<int D>
+void InteractionCacheN<D>::assignMembers(const NodeN<D>* node, size_t group) {
+    if (node == nullptr || node->isEmpty()) {
+        return;
+    }
+    if (node->getParticleIndex() != NodeN<D>::NO_PARTICLE) {
+        particle_group[node->getParticleIndex()] = group;
+        return;
+    }
+    for (int c = 0; c < NodeN<D>::NUM_CHILDREN; ++c) {
+        assignMembers(node->getChild(c), group);
+    }
+}
+
+template<int D>
+void InteractionCacheN<D>::collect(const NodeN<D>* node, size_t number, const BoxN<D>& group_box, double theta,
+                                   double r_cut, double& margin) {
+    // leaves are always taken directly, from current positions
+    if (node->getParticleIndex() != NodeN<D>::NO_PARTICLE) {
+        direct.push_back(node->getParticleIndex());
+        return;
+    }
+
+    double gap = std::sqrt(group_box.distanceSquaredTo(node->getBox()));
+
+    // TreePM: far beyond the cutoff for every member, the half-gap is the drift allowance,
+    // keeping room for the cutoff itself to grow to CUTOFF_GROWTH * r_cut
+    if (r_cut > 0.0 && gap > CUTOFF_SLACK * r_cut) {
+        double required = (gap - CUTOFF_GROWTH * r_cut) / 2.0;
+        margin = std::min(margin, required);
+        node_margin[number] = std::min(node_margin[number], required);
+        return;
+    }
+
+    // nodes overlapping the group (its ancestors and itself) hold members, always open them
+    double d = std::sqrt(group_box.distanceSquaredTo(node->getCenterOfMass()));
+    double s = node->getBox().getSideLength();
+    if (gap > 0.0 && s < ACCEPT_FRACTION * theta * d) {
+        nodes.push_back(node);
+        // members and the node's mass may each drift by m: the distance shrinks by 2m and the
+        // node's extent grows by 2m, (s + 2m) / (d - 2m) < theta holds for m below this
+        double required = (theta * d - s) / (2.0 * theta + 2.0);
+        margin = std::min(margin, required);
+        node_margin[number] = std::min(node_margin[number], required);
+        return;
+    }
+
+    size_t child_number = number + 1;
+    for (int c = 0; c < NodeN<D>::NUM_CHILDREN; ++c) {
+        const NodeN<D>* child = node->getChild(c);
+        if (child != nullptr && !child->isEmpty()) {
+            collect(child, child_number, group_box, theta, r_cut, margin);
+            child_number += subtree_size[child_number];
+        }
+    }
+}
+
+template<int D>
+void InteractionCacheN<D>::limitMargins(const NodeN<D>* node, size_t number, double limit) {
+    limit = std::min(limit, node_margin[number]);
+
+    if (node->getParticleIndex() != NodeN<D>::NO_PARTICLE) {
+        size_t i = node->getParticleIndex();
+        particle_margin[i] = std::min(group_margin[particle_group[i]], limit);
+        return;
+    }
+    size_t child_number = number + 1;
+    for (int c = 0; c < NodeN<D>::NUM_CHILDREN; ++c) {
+        const NodeN<D>* child = node->getChild(c);
+        if (child != nullptr && !child->isEmpty()) {
+            limitMargins(child, child_number, limit);
+            child_number += subtree_size[child_number];
+        }
+    }
+}
+
+template<int D>
+void InteractionCacheN<D>::build(const NodeN<D>* root, const ParticleSpanN<D>& particles, double theta,
+                                 double r_cut) {
+    valid = false;
+    if (root == nullptr || root->isEmpty()) {
+        return;
+    }
+    group_roots.clear();
+    findGroups(root);
+    subtree_size.clear();
+    numberSubtree(root);
+    // keep node_margin's headroom in step with subtree_size's, so a few extra nodes in the
+    // next tree do not reallocate
+    node_margin.reserve(subtree_size.capacity());
+    node_margin.assign(subtree_size.size(), std::numeric_limits<double>::max());
+
+    const size_t num_groups = group_roots.size();
+    particle_group.resize(particles.count);
+    group_margin.resize(num_groups);
+    node_offsets.resize(num_groups + 1);
+    direct_offsets.resize(num_groups + 1);
+    nodes.clear();
+    direct.clear();
+
+    node_offsets[0] = 0;
+    direct_offsets[0] = 0;
+    for (size_t g = 0; g < num_groups; ++g) {
+        const NodeN<D>* group = group_roots[g];
+        assignMembers(group, g);
+
+        // without accepted nodes the lists are exact at any drift, still rebuild once members
+        // have crossed about a group width so the grouping does not go stale
+        double margin = group->getBox().getSideLength();
+        collect(root, 0, group->getBox(), theta, r_cut, margin);
+        group_margin[g] = std::max(margin, 0.0);
+
+        node_offsets[g + 1] = nodes.size();
+        direct_offsets[g + 1] = direct.size();
+    }
+
+    // a listed node's center of mass and extent move with its own particles, so they are held
+    // to that node's margin as well, whichever group listed it
+    particle_margin.resize(particles.count);
+    limitMargins(root, 0, std::numeric_limits<double>::max());
+
+    reference_pos.resize(particles.count);
+    for (size_t i = 0; i < particles.count; ++i) {
+        reference_pos[i] = particles.getPos(i);
+    }
+
+    list_theta = theta;
+    list_cut = r_cut;
+    valid = true;
+}
+
+template<int D>
+bool InteractionCacheN<D>::withinMargin(const ParticleSpanN<D>& particles) const {
+    if (!valid || particles.count != reference_pos.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < particles.count; ++i) {
+        double m = particle_margin[i];
+        if ((particles.getPos(i) - reference_pos[i]).magnitude_sq() > m * m) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<int D>
+void InteractionCacheN<D>::accumulate(size_t i, const VecN<D>& pos, const ParticleSpanN<D>& particles,
+                                      double G, double r_split, double r_cut, VecN<D>& acc) const {
+    const size_t g = particle_group[i];
+
+    auto add = [&](const VecN<D>& source, double mass) {
+        VecN<D> r_vec = source - pos;
+        double dist_sq = r_vec.magnitude_sq();
+        if (dist_sq < std::numeric_limits<double>::epsilon()) {
+            return;
+        }
+        double dist = std::sqrt(dist_sq);
+        double factor = 1.0;
+        if (r_split > 0.0) {
+            if (dist > r_cut) {
+                return;
+            }
+            factor = NodeN<D>::shortRangeFactor(dist, r_split);
+        }
+        acc = acc + r_vec * (G * mass * factor / (dist_sq * dist));
+    };
+
+    for (size_t k = node_offsets[g]; k < node_offsets[g + 1]; ++k) {
+        add(nodes[k]->getCenterOfMass(), nodes[k]->getTotalMass());
+    }
+    for (size_t k = direct_offsets[g]; k < direct_offsets[g + 1]; ++k) {
+        size_t j = direct[k];
+        if (j != i) {
+            add(particles.getPos(j), particles.getMass(j));
+        }
+    }
+}
+
+template class InteractionCacheN<2>;
+template class InteractionCacheN<3>;
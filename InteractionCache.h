@@ -0,0 +1,105 @@
+//
+// Created by sailsec on 10/19/26.
+//
+
+#ifndef INTERACTIONCACHE_H
+#define INTERACTIONCACHE_H
+
+#include <vector>
+
+#include "Box.h"
+#include "Node.h"
+#include "ParticleSpan.h"
+#include "Vec.h"
+
+// Interaction lists cached across steps, for systems where particles move far less than their
+// leaf size between steps.
+// Particles are grouped under the deepest nodes holding at most group_size of them. For each
+// group, one walk against the group's box records the nodes accepted as monopoles and the
+// particles taken directly. Nodes are accepted with a stricter angle than theta, and the slack
+// left over bounds how far the group's members and the node's own particles may drift. Each
+// particle's margin is the tightest of these over its group's lists and over every listed node
+// containing it. While no particle has moved further than its margin since the lists were
+// built, every recorded node still passes the theta test from every member, so a step only
+// needs to refit the node moments (Node::refit) and run through the lists, with no
+// opening-criterion walk.
+template<int D>
+class InteractionCacheN {
+
+private:
+    // accepted nodes must satisfy s < ACCEPT_FRACTION * theta * d at build time
+    static constexpr double ACCEPT_FRACTION = 0.9;
+    // TreePM: nodes up to this many cutoff radii away stay listed, beyond it they are dropped
+    static constexpr double CUTOFF_SLACK = 1.1;
+    // TreePM: the mesh may re-derive the cutoff on reuse, the lists stay exact up to this growth
+    static constexpr double CUTOFF_GROWTH = 1.05;
+
+    size_t group_size;
+    double list_theta = 0.0;
+    double list_cut = 0.0;
+    bool valid = false;
+
+    std::vector<size_t> particle_group;          // group of each particle
+    std::vector<double> particle_margin;         // allowed drift per particle
+    std::vector<VecN<D>> reference_pos;          // positions when the lists were built
+
+    // per-group lists, compressed rows: group g owns [offsets[g], offsets[g + 1])
+    std::vector<size_t> node_offsets;
+    std::vector<const NodeN<D>*> nodes;
+    std::vector<size_t> direct_offsets;
+    std::vector<size_t> direct;
+
+    // scratch for build
+    std::vector<const NodeN<D>*> group_roots;
+    std::vector<double> group_margin;            // drift allowed to each group's members
+    // per node in preorder (empty nodes skipped): the size of its subtree, and the drift it
+    // allows its own particles as the tightest over the lists that accepted or pruned it
+    std::vector<size_t> subtree_size;
+    std::vector<double> node_margin;
+
+    // Fills subtree_size in preorder, returns the size of node's subtree
+    size_t numberSubtree(const NodeN<D>* node);
+
+    // Finds the group roots below node, depth first
+    void findGroups(const NodeN<D>* node);
+    void assignMembers(const NodeN<D>* node, size_t group);
+
+    // Walks the tree against one group's box, appending to the current rows.
+    // number is node's preorder number.
+    void collect(const NodeN<D>* node, size_t number, const BoxN<D>& group_box, double theta, double r_cut,
+                 double& margin);
+
+    // Sets particle_margin below node, limit being the tightest node margin above it
+    void limitMargins(const NodeN<D>* node, size_t number, double limit);
+
+public:
+    explicit InteractionCacheN(size_t group_size = 8);
+
+    void invalidate() {
+        valid = false;
+    }
+    bool isValidFor(double theta) const {
+        return valid && theta == list_theta;
+    }
+    // post: true while the lists still cover the short-range cutoff r_cut (0 without TreePM)
+    bool coversCutoff(double r_cut) const {
+        return r_cut <= CUTOFF_GROWTH * list_cut;
+    }
+
+    // Builds the lists for a freshly built tree. r_cut > 0 is the TreePM short-range cutoff.
+    void build(const NodeN<D>* root, const ParticleSpanN<D>& particles, double theta, double r_cut);
+
+    // post: true while every particle is within its margin of its reference position
+    bool withinMargin(const ParticleSpanN<D>& particles) const;
+
+    // Adds the acceleration on particle i at pos from its group's lists.
+    // r_split > 0 applies the TreePM short-range factor and drops interactions beyond r_cut.
+    void accumulate(size_t i, const VecN<D>& pos, const ParticleSpanN<D>& particles, double G,
+                    double r_split, double r_cut, VecN<D>& acc) const;
+};
+
+using InteractionCache2 = InteractionCacheN<2>;
+using InteractionCache3 = InteractionCacheN<3>;
+using InteractionCache = InteractionCache3; // the default 3D build
+
+#endif //INTERACTIONCACHE_H
@@ -4,37 +4,54 @@
 
 #include "Node.h"
 
+#include <limits>
+#include <stdexcept>
+
 // Adds a particle to this node or recursively to one of its children.
-    void Node::addParticle(Particle* newParticle, NodePool& pool) {
-        updateMassAndCenterOfMass(newParticle);
+template<int D>
+    void NodeN<D>::addParticle(size_t index, const VecN<D>& pos, double mass, NodePoolN<D>& pool) {
+        // a leaf's center of mass and mass are its particle's, keep them for the split below
+        const VecN<D> leafPos = centerOfMass;
+        const double leafMass = totalMass;
+
+        updateMassAndCenterOfMass(pos, mass);
+        ++particleCount;
 
         if (isEmpty()) {
-            particle = newParticle;
-        } else if (particle != nullptr) {
-            Particle* oldParticle = particle;
-            particle = nullptr;
+            particle = index;
+        } else if (particle != NO_PARTICLE) {
+            // coincident particles would split this leaf forever, as would boxes too small
+            // for their halves to differ in floating point
+            if ((leafPos - pos).magnitude_sq() == 0.0
+                || box.getSideLength() <= 4.0 * std::numeric_limits<double>::epsilon() * box.getCenter().magnitude()) {
+                throw std::runtime_error("Node::addParticle: particles too close to separate");
+            }
 
-            std::array<Box, 8> childBoxes = box.subdivide();
+            size_t oldParticle = particle;
+            particle = NO_PARTICLE;
 
-            int oldIndex = box.getOctantIndex(oldParticle->getPos());
+            // only the children that receive a particle are boxed, not all NUM_CHILDREN
+            int oldIndex = box.getOctantIndex(leafPos);
             if (children[oldIndex] == nullptr) {
-                children[oldIndex] = pool.acquireNode(childBoxes[oldIndex]);
+                children[oldIndex] = pool.acquireNode(box.childBox(oldIndex));
             }
-            children[oldIndex]->addParticle(oldParticle, pool);
+            children[oldIndex]->addParticle(oldParticle, leafPos, leafMass, pool);
 
-            int newIndex = box.getOctantIndex(newParticle->getPos());
+            int newIndex = box.getOctantIndex(pos);
             if (children[newIndex] == nullptr) {
-                children[newIndex] = pool.acquireNode(childBoxes[newIndex]);
+                children[newIndex] = pool.acquireNode(box.childBox(newIndex));
             }
-            children[newIndex]->addParticle(newParticle, pool);
+            children[newIndex]->addParticle(index, pos, mass, pool);
 
         } else {
-            int targetIndex = box.getOctantIndex(newParticle->getPos());
-            std::array<Box, 8> childBoxes = box.subdivide();
+            int targetIndex = box.getOctantIndex(pos);
 
             if (children[targetIndex] == nullptr) {
-                children[targetIndex] = pool.acquireNode(childBoxes[targetIndex]);
+                children[targetIndex] = pool.acquireNode(box.childBox(targetIndex));
             }
-            children[targetIndex]->addParticle(newParticle, pool);
+            children[targetIndex]->addParticle(index, pos, mass, pool);
         }
-    }
\ No newline at end of file
+    }
+
+template class NodeN<2>;
+template class NodeN<3>;
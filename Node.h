@@ -9,111 +9,153 @@
 #include "Vec.h"
 #include <array>
 #include <limits> // For std::numeric_limits
-#include <cmath>  // For std::sqrt
+#include <cmath>  // For std::sqrt, std::erfc, std::exp
+#include <numbers>
 
 #include "NodePool.h"
 #include "Particle.h"
+#include "ParticleSpan.h"
 
-class NodePool;
-struct Box;
+template<int D> class NodePoolN;
+template<int D> struct BoxN;
 
-class Node {
+// One cell of the tree: a quadtree node for D = 2, an octree node for D = 3
+template<int D>
+class NodeN {
+
+public:
+    static constexpr int NUM_CHILDREN = BoxN<D>::NUM_CHILDREN;
+    static constexpr size_t NO_PARTICLE = std::numeric_limits<size_t>::max();
 
 private:
-    Box box;                  // The spatial bounding box of this node
+    BoxN<D> box;              // The spatial bounding box of this node
     double totalMass;         // The total mass of all particles within this node's subtree
-    Vec centerOfMass;         // The center of mass of all particles within this node's subtree
-    Particle* particle;       // Points to a single particle if it's a leaf; nullptr otherwise
-    std::array<Node*, 8> children; // NodePool-managed raw pointers to child nodes
+    VecN<D> centerOfMass;     // The center of mass of all particles within this node's subtree
+    size_t particle;          // Index of the single particle if it's a leaf; NO_PARTICLE otherwise
+    size_t particleCount;     // Number of particles within this node's subtree
+    std::array<NodeN*, NUM_CHILDREN> children; // NodePool-managed raw pointers to child nodes
 
     // Private helper: checks if ALL child pointers are null
     bool areAllChildrenNull() const {
-        for (const Node* child : children) {
+        for (const NodeN* child : children) {
             if (child != nullptr) {
                 return false;
             }
         }
         return true;
     }
-    friend class NodePool; // Allows NodePool to access private members/constructor
+    friend class NodePoolN<D>; // Allows NodePool to access private members/constructor
 
     // Helper to update the node's total mass and center of mass incrementally
-    void updateMassAndCenterOfMass(const Particle* p) {
+    void updateMassAndCenterOfMass(const VecN<D>& pos, double mass) {
         if (totalMass == 0.0) {
-            centerOfMass = p->getPos();
-            totalMass = p->getMass();
+            centerOfMass = pos;
+            totalMass = mass;
         } else {
-            centerOfMass = ((centerOfMass * totalMass) + (p->getPos() * p->getMass())) / (totalMass + p->getMass());
-            totalMass += p->getMass();
+            centerOfMass = ((centerOfMass * totalMass) + (pos * mass)) / (totalMass + mass);
+            totalMass += mass;
         }
     }
 
 public:
 
     // Node constructor (now public for std::make_unique but still intended for NodePool use)
-    Node(const Box& box_val)
+    NodeN() : NodeN(BoxN<D>()) {}
+    NodeN(const BoxN<D>& box_val)
         : box(box_val),
           totalMass(0.0),
-          centerOfMass(Vec()),
-          particle(nullptr) {
-        for (Node*& child : children) {
+          centerOfMass(VecN<D>()),
+          particle(NO_PARTICLE),
+          particleCount(0) {
+        for (NodeN*& child : children) {
             child = nullptr;
         }
     }
 
     // --- State Checkers ---
     bool isLeaf() const {
-        return particle != nullptr || areAllChildrenNull();
+        return particle != NO_PARTICLE || areAllChildrenNull();
     }
     bool isEmpty() const {
-        return particle == nullptr && areAllChildrenNull();
+        return particle == NO_PARTICLE && areAllChildrenNull();
     }
     bool isInternal() const { // Convenience helper
         return !isLeaf() && !isEmpty();
     }
 
     // --- Getters ---
-    const Box& getBox() const {
+    const BoxN<D>& getBox() const {
         return box;
     }
     double getTotalMass() const {
         return totalMass;
     }
-    const Vec& getCenterOfMass() const {
+    const VecN<D>& getCenterOfMass() const {
         return centerOfMass;
     }
-    Node* getChild(int index) const {
+    NodeN* getChild(int index) const {
         return children[index];
     }
-    const Particle* getParticle() const {
+    size_t getParticleIndex() const {
         return particle;
     }
+    size_t getParticleCount() const {
+        return particleCount;
+    }
 
     // Core node ops
 
     // Resets the node's state for reuse from the NodePool.
-    void reset(const Box& new_box) {
+    void reset(const BoxN<D>& new_box) {
         this->box = new_box;
         totalMass = 0.0;
-        particle = nullptr;
-        centerOfMass = Vec();
-        for (Node*& child : children) {
+        particle = NO_PARTICLE;
+        particleCount = 0;
+        centerOfMass = VecN<D>();
+        for (NodeN*& child : children) {
             child = nullptr;
         }
     }
 
-    void addParticle(Particle *newParticle, NodePool &pool);
+    // Inserts particle index at pos with mass into this node's subtree.
+    // throws std::runtime_error if pos coincides with a particle already in the subtree
+    void addParticle(size_t index, const VecN<D>& pos, double mass, NodePoolN<D> &pool);
+
+    // Recomputes total mass and center of mass bottom-up from the current particle data, keeping
+    // the tree's shape. Boxes are not moved, so particles may since have drifted outside them.
+    void refit(const ParticleSpanN<D>& particles) {
+        if (particle != NO_PARTICLE) {
+            centerOfMass = particles.getPos(particle);
+            totalMass = particles.getMass(particle);
+            return;
+        }
+        VecN<D> weighted;
+        totalMass = 0.0;
+        for (NodeN* child : children) {
+            if (child != nullptr) {
+                child->refit(particles);
+                weighted = weighted + child->centerOfMass * child->totalMass;
+                totalMass += child->totalMass;
+            }
+        }
+        centerOfMass = (totalMass > 0.0) ? weighted / totalMass : box.getCenter();
+    }
 
-    // Recursively calculates the force exerted by this node (or its subtree) on a target particle.
-    void calculateForceOn(Particle* target_particle, double theta, double G) const {
+    // Recursively accumulates into acc the acceleration this node (or its subtree) exerts on
+    // the particle with index target at target_pos.
+    // A leaf's center of mass and total mass are those of its single particle, so leaves
+    // need no particle data and the walk only reads nodes.
+    void calculateAccelerationOn(size_t target, const VecN<D>& target_pos, double theta, double G,
+                                 VecN<D>& acc) const {
         if (isEmpty()) {
             return;
         }
-        if (particle == target_particle && isLeaf()) {
+        if (particle == target && isLeaf()) {
             return;
         }
 
-        Vec r_vec = target_particle->getPos() - getCenterOfMass();
+        // points from the target toward the mass, gravity is attractive
+        VecN<D> r_vec = getCenterOfMass() - target_pos;
         double dist_sq = r_vec.magnitude_sq();
 
         if (dist_sq < std::numeric_limits<double>::epsilon()) {
@@ -121,30 +163,57 @@ public:
         }
         double dist = std::sqrt(dist_sq);
 
-        if (approximationCondition(dist, theta)) {
-            double force_magnitude = (G * target_particle->getMass() * totalMass) / dist_sq;
-            Vec direction = r_vec.normalized();
-            Vec force_vec = direction * force_magnitude;
-            target_particle->addAccumulatedForce(force_vec);
+        if (particle != NO_PARTICLE || approximationCondition(dist, theta)) {
+            // a = G M / r^2 along r_vec, either the whole cell or the direct particle
+            acc = acc + r_vec * (G * totalMass / (dist_sq * dist));
         } else {
-            if (isInternal()) {
-                for (Node* child : children) {
-                    if (child != nullptr) {
-                        child->calculateForceOn(target_particle, theta, G);
-                    }
+            for (NodeN* child : children) {
+                if (child != nullptr) {
+                    child->calculateAccelerationOn(target, target_pos, theta, G, acc);
                 }
-            } else {
-                if (particle != nullptr) {
-                    Vec direct_r_vec = target_particle->getPos() - particle->getPos();
-                    double direct_dist_sq = direct_r_vec.magnitude_sq();
-                    if (direct_dist_sq < std::numeric_limits<double>::epsilon()) {
-                        return;
-                    }
-
-                    double direct_force_magnitude = (G * target_particle->getMass() * particle->getMass()) / direct_dist_sq;
-                    Vec direct_force_direction = direct_r_vec.normalized();
-                    Vec direct_force_vec = direct_force_direction * direct_force_magnitude;
-                    target_particle->addAccumulatedForce(direct_force_vec);
+            }
+        }
+    }
+
+    // TreePM split: fraction of the Newtonian force at distance r that belongs to the tree.
+    // The mesh supplies the rest, the long-range part of -G M erf(r / 2 r_s) / r.
+    static double shortRangeFactor(double r, double r_split) {
+        double u = r / (2.0 * r_split);
+        return std::erfc(u) + (2.0 * u / std::sqrt(std::numbers::pi)) * std::exp(-u * u);
+    }
+
+    // Short-range half of the TreePM acceleration on a target particle.
+    // Same walk as calculateAccelerationOn, with each interaction scaled by shortRangeFactor and
+    // whole subtrees skipped once their box lies beyond r_cut.
+    void calculateShortRangeAccelerationOn(size_t target, const VecN<D>& target_pos, double theta, double G,
+                                           double r_split, double r_cut, VecN<D>& acc) const {
+        if (isEmpty()) {
+            return;
+        }
+        if (particle == target && isLeaf()) {
+            return;
+        }
+        // nothing in this subtree lies within the cutoff
+        if (box.distanceSquaredTo(target_pos) > r_cut * r_cut) {
+            return;
+        }
+
+        VecN<D> r_vec = getCenterOfMass() - target_pos;
+        double dist_sq = r_vec.magnitude_sq();
+
+        if (dist_sq < std::numeric_limits<double>::epsilon()) {
+            return;
+        }
+        double dist = std::sqrt(dist_sq);
+
+        if (particle != NO_PARTICLE || approximationCondition(dist, theta)) {
+            // a leaf's center of mass is its particle, so this covers the direct case too
+            double acc_magnitude = G * totalMass / dist_sq * shortRangeFactor(dist, r_split);
+            acc = acc + r_vec * (acc_magnitude / dist);
+        } else {
+            for (NodeN* child : children) {
+                if (child != nullptr) {
+                    child->calculateShortRangeAccelerationOn(target, target_pos, theta, G, r_split, r_cut, acc);
                 }
             }
         }
@@ -158,16 +227,16 @@ public:
 
     // Potential
 
-    void calculatePotentialOn(Particle* target_particle, double theta, double G, double softening_epsilon) const {
+    void calculatePotentialOn(size_t target, const VecN<D>& target_pos, double theta, double G, double softening_epsilon) const {
         if (isEmpty()) {
             return;
         }
-        if (particle == target_particle && isLeaf()) {
+        if (particle == target && isLeaf()) {
             return;
         }
 
         // calculate distance vec, and squared distance from target particle to this nodes CM
-        Vec r_vec = target_particle->getPos() - getCenterOfMass();
+        VecN<D> r_vec = target_pos - getCenterOfMass();
         double dist_sq = r_vec.magnitude_sq();
 
         // apply the softening parameter and check for epsilon
@@ -186,11 +255,10 @@ public:
 
 
     }
-
-
-    void calculateAccelerationOn(Particle* target_particle, double theta, double G) const {
-
-    }
 };
 
+using Node2 = NodeN<2>;
+using Node3 = NodeN<3>;
+using Node = Node3; // the default 3D build
+
 #endif //NODE_H
\ No newline at end of file
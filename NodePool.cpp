@@ -5,16 +5,31 @@
 #include "NodePool.h"
 
 // Acquires a node from the pool. Resets its state with the given box.
-    Node* NodePool::acquireNode(const Box& box) {
-        if (free_nodes_pointers.empty()) {
-            expandPoolMemory(); // Expand if no free nodes
-            if (free_nodes_pointers.empty()) { // Check again after expansion
-                throw std::runtime_error("NodePool failed to acquire node: No free nodes after expansion.");
+template<int D>
+    NodeN<D>* NodePoolN<D>::acquireNode(const BoxN<D>& box) {
+        NodeN<D>* node = nullptr;
+
+        if (!free_nodes_pointers.empty()) {
+            node = free_nodes_pointers.back();
+            free_nodes_pointers.pop_back();
+        } else {
+            // move the cursor on to the next block, growing the pool when past the last one
+            while (current_block < blocks.size() && next_in_block == block_sizes[current_block]) {
+                ++current_block;
+                next_in_block = 0;
+            }
+            if (current_block == blocks.size()) {
+                expandPoolMemory((capacity == 0) ? 100 : capacity); // Double capacity, or start with 100
             }
+            node = &blocks[current_block][next_in_block++];
         }
 
-        Node* node = free_nodes_pointers.back();
-        free_nodes_pointers.pop_back();
+        if (node == nullptr) {
+            throw std::runtime_error("NodePool failed to acquire node: No free nodes after expansion.");
+        }
         node->reset(box); // Reset the node with the new bounding box
         return node;
-    }
\ No newline at end of file
+    }
+
+template class NodePoolN<2>;
+template class NodePoolN<3>;
@@ -12,58 +12,68 @@
 #include "Box.h"
 #include "Node.h"
 
-class Node;
+template<int D> class NodeN;
 
-class NodePool {
+// Owns every node of one tree, D = 2 for a quadtree pool, D = 3 for an octree pool
+template<int D>
+class NodePoolN {
 
 private:
-    // Member declarations are now *inside* the class scope
-    std::vector<std::unique_ptr<Node>> all_nodes_storage; // The total storage of Node objects (owned)
-    std::vector<Node*> free_nodes_pointers;              // List of raw pointers to currently free nodes
+    // Nodes live in blocks that never move or get freed while the pool lives, so the raw
+    // child pointers stay valid. Acquiring bumps a cursor through the blocks, and a reset
+    // just rewinds it: once a build has grown the pool to size, later builds of a similar
+    // tree never touch the heap.
+    std::vector<std::unique_ptr<NodeN<D>[]>> blocks; // The total storage of Node objects (owned)
+    std::vector<size_t> block_sizes;
+    size_t capacity = 0;                              // nodes across all blocks
 
-    // Expands the pool's memory when more nodes are needed.
-    void expandPoolMemory() {
-        size_t old_capacity = all_nodes_storage.size();
-        size_t new_capacity = (old_capacity == 0) ? 100 : old_capacity * 2; // Double capacity, or start with 100
+    size_t current_block = 0;                         // bump cursor: block, then slot within it
+    size_t next_in_block = 0;
 
-        all_nodes_storage.reserve(new_capacity); // Reserve new capacity to avoid reallocations
+    std::vector<NodeN<D>*> free_nodes_pointers;      // List of raw pointers to released nodes, reused first
 
-        // Add new nodes to the storage and to the free list
-        for (size_t i = old_capacity; i < new_capacity; ++i) {
-            all_nodes_storage.push_back(std::make_unique<Node>(Box())); // Node constructor is now public
-            free_nodes_pointers.push_back(all_nodes_storage.back().get());
-        }
+    // Expands the pool's memory when more nodes are needed.
+    void expandPoolMemory(size_t count) {
+        blocks.push_back(std::make_unique<NodeN<D>[]>(count)); // Node default constructor is public
+        block_sizes.push_back(count);
+        capacity += count;
     }
 
 public:
     // Constructor: Pre-allocates initialCapacity nodes.
-    NodePool(size_t initialCapacity) {
-        all_nodes_storage.reserve(initialCapacity);
-        for (size_t i = 0; i < initialCapacity; ++i) {
-            all_nodes_storage.push_back(std::make_unique<Node>(Box()));
-            free_nodes_pointers.push_back(all_nodes_storage.back().get());
+    NodePoolN(size_t initialCapacity) {
+        if (initialCapacity > 0) {
+            expandPoolMemory(initialCapacity);
         }
     }
 
-    Node *acquireNode(const Box &box);
+    size_t getCapacity() const {
+        return capacity;
+    }
+
+    NodeN<D> *acquireNode(const BoxN<D> &box);
 
     // Releases a node back to the pool (adds it to the free list).
-    void releaseNode(Node* node) { // Renamed from 'release' for clarity
+    void releaseNode(NodeN<D>* node) { // Renamed from 'release' for clarity
         if (node != nullptr) {
             free_nodes_pointers.push_back(node);
         }
     }
 
     // Resets the pool, making all nodes available for reuse in the next tree build.
+    // Invalidates every node handed out so far.
     void resetPool() {
-        free_nodes_pointers.clear(); // Clear the current list of free nodes
-        for (const auto& node_ptr : all_nodes_storage) {
-            free_nodes_pointers.push_back(node_ptr.get()); // Add ALL nodes back to the free list
-        }
+        free_nodes_pointers.clear(); // keeps its capacity
+        current_block = 0;
+        next_in_block = 0;
     }
 
     // Destructor (unique_ptr handles memory, so default is fine).
-    ~NodePool() = default;
+    ~NodePoolN() = default;
 };
 
+using NodePool2 = NodePoolN<2>;
+using NodePool3 = NodePoolN<3>;
+using NodePool = NodePool3; // the default 3D build
+
 #endif //NODEPOOL_H
\ No newline at end of file
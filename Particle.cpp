@@ -3,3 +3,6 @@
 //
 
 #include "Particle.h"
+
+template class ParticleN<2>;
+template class ParticleN<3>;
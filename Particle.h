@@ -5,16 +5,21 @@
 #ifndef PARTICLE_H
 #define PARTICLE_H
 
+#include <vector>
+
+#include "ParticleSpan.h"
 #include "Vec.h" // Ensure Vec is properly defined and accessible
 
 // The Particle class represents a single body in this N-body simulation.
 // It holds its physical properties and manages its state changes over time.
+// D is the dimension of the simulation (2 or 3).
 
-class Particle {
+template<int D>
+class ParticleN {
 private:
-    Vec pos;          // Position vector
-    Vec vel;          // Velocity vector
-    Vec acc;          // Accumulated acceleration vector (sum of forces / mass)
+    VecN<D> pos;      // Position vector
+    VecN<D> vel;      // Velocity vector
+    VecN<D> acc;      // Accumulated acceleration vector (sum of forces / mass)
     double mass;      // Mass of the particle
     int id;           // Unique identifier for the particle (useful for debugging/tracking)
 
@@ -24,15 +29,15 @@ private:
 public:
     // Constructor: Initializes a particle with its properties.
     // Provides default values for velocity, acceleration, and ID for convenience.
-    Particle(Vec pos_ = Vec(), Vec vel_ = Vec(), Vec acc_ = Vec(), double mass_ = 1.0, int id_ = 0)
+    ParticleN(VecN<D> pos_ = VecN<D>(), VecN<D> vel_ = VecN<D>(), VecN<D> acc_ = VecN<D>(), double mass_ = 1.0, int id_ = 0)
         : pos(pos_), vel(vel_), acc(acc_), mass(mass_), id(id_) {
         // No heap allocation needed for Vec members, they are value types
     }
 
     // --- Getters (const-correctness and reference returns for efficiency) ---
-    const Vec& getPos() const { return pos; }
-    const Vec& getVel() const { return vel; }
-    const Vec& getAcc() const { return acc; }
+    const VecN<D>& getPos() const { return pos; }
+    const VecN<D>& getVel() const { return vel; }
+    const VecN<D>& getAcc() const { return acc; }
     double getMass() const { return mass; }
     int getId() const { return id; }
 
@@ -41,12 +46,12 @@ public:
     // Resets the accumulated acceleration (or force) for the current time step.
     // Called at the beginning of each force calculation phase.
     void resetAccumulatedForce() {
-        acc = Vec(); // Set acceleration vector to (0,0,0)
+        acc = VecN<D>(); // Set acceleration vector to (0,0,0)
     }
 
     // Adds a force vector to the particle's accumulated acceleration.
     // Internally converts force to acceleration (F/m).
-    void addAccumulatedForce(const Vec& force) {
+    void addAccumulatedForce(const VecN<D>& force) {
         if (mass > 0) {
             acc = acc + (force / mass); // F = ma, so a = F/m
         }
@@ -60,7 +65,24 @@ public:
         pos= pos + (vel * dt); // Update position based on new velocity
 
         // Reset acceleration for the next time step's force accumulation.
-        acc = Vec();
+        acc = VecN<D>();
+    }
+
+    // Strided view of a Particle array, so the tree engine can run on it in place.
+    // Invalidated when the vector reallocates.
+    static ParticleSpanN<D> spanOf(std::vector<ParticleN>& particles) {
+        ParticleSpanN<D> span;
+        span.count = particles.size();
+        if (particles.empty()) {
+            return span;
+        }
+        ParticleN& first = particles.front();
+        span.pos = first.pos.c;
+        span.vel = first.vel.c;
+        span.acc = first.acc.c;
+        span.mass = &first.mass;
+        span.pos_stride = span.vel_stride = span.acc_stride = span.mass_stride = sizeof(ParticleN);
+        return span;
     }
 
     // ADDED: Resets the accumulated potential for the current time step.
@@ -74,4 +96,8 @@ public:
     }
 };
 
+using Particle2 = ParticleN<2>;
+using Particle3 = ParticleN<3>;
+using Particle = Particle3; // the default 3D build
+
 #endif //PARTICLE_H
\ No newline at end of file
@@ -0,0 +1,160 @@
+//
+// Created by sailsec on 10/19/26.
+//
+
+#include "ParticleMesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+
+static int checkedMeshCells(int mesh_cells) {
+    if (mesh_cells < 8 || (mesh_cells & (mesh_cells - 1)) != 0) {
+        throw std::invalid_argument("ParticleMesh: mesh_cells must be a power of two, at least 8");
+    }
+    return mesh_cells;
+}
+
+template<int D>
+ParticleMeshN<D>::ParticleMeshN(int mesh_cells, double split_cells, double cutoff_splits)
+    : cells(checkedMeshCells(mesh_cells)),
+      padded(2 * cells),
+      split_cells(split_cells),
+      cutoff_splits(cutoff_splits),
+      fft(2 * cells) {
+    if (split_cells <= 0.0 || cutoff_splits <= 0.0) {
+        throw std::invalid_argument("ParticleMesh: split and cutoff must be positive");
+    }
+
+    size_t total = 1;
+    for (int k = 0; k < D; ++k) {
+        total *= padded;
+    }
+    grid.resize(total);
+    green.resize(total);
+}
+
+template<int D>
+void ParticleMeshN<D>::locate(const VecN<D>& pos, int (&lower)[D], double (&frac)[D]) const {
+    for (int k = 0; k < D; ++k) {
+        // cell i is centered at origin + (i + 0.5) h
+        double u = (pos[k] - origin[k]) / h - 0.5;
+        // keep both weights and their gradient neighbours inside [0, cells)
+        u = std::clamp(u, 1.0, cells - 2.0 - 1e-9);
+        lower[k] = static_cast<int>(u);
+        frac[k] = u - lower[k];
+    }
+}
+
+template<int D>
+void ParticleMeshN<D>::buildGreen(double G) {
+    const double r_split = split_cells * h;
+
+    int cell[D] = {};
+    for (size_t index = 0; index < green.size(); ++index) {
+        // offsets wrap to [-cells, cells) so the circular convolution acts as an isolated one
+        double r_sq = 0.0;
+        for (int k = 0; k < D; ++k) {
+            int d = (cell[k] < cells) ? cell[k] : cell[k] - padded;
+            r_sq += double(d) * d;
+        }
+        double r = std::sqrt(r_sq) * h;
+
+        // potential of the long-range part: -G erf(r / 2 r_s) / r, finite at r = 0
+        double value = (r > 0.0) ? -G * std::erf(r / (2.0 * r_split)) / r
+                                 : -G / (r_split * std::sqrt(std::numbers::pi));
+        green[index] = value;
+
+        for (int k = D - 1; k >= 0; --k) {
+            if (++cell[k] < padded) break;
+            cell[k] = 0;
+        }
+    }
+
+    fft.transformGrid(green.data(), D, false);
+    green_h = h;
+    green_G = G;
+}
+
+template<int D>
+void ParticleMeshN<D>::solve(const ParticleSpanN<D>& particles, const BoxN<D>& bounds, double G) {
+    // two guard cells each side keep deposits and gradients off the padding
+    double needed_h = bounds.getSideLength() / (cells - 4);
+    if (!(needed_h > 0.0)) {
+        needed_h = 1.0; // all particles coincide, any spacing will do
+    }
+
+    // the Green's function only depends on h, reuse it while the box stays within a few percent
+    if (green_G == G && needed_h <= green_h && needed_h >= 0.95 * green_h) {
+        h = green_h;
+    } else {
+        h = needed_h * 1.02;
+        buildGreen(G);
+    }
+    for (int k = 0; k < D; ++k) {
+        origin[k] = bounds.min[k] - 2.0 * h;
+    }
+
+    std::fill(grid.begin(), grid.end(), std::complex<double>());
+
+    // cloud-in-cell deposit
+    for (size_t i = 0; i < particles.count; ++i) {
+        int lower[D];
+        double frac[D];
+        locate(particles.getPos(i), lower, frac);
+        for (int corner = 0; corner < (1 << D); ++corner) {
+            int cell[D];
+            double weight = particles.getMass(i);
+            for (int k = 0; k < D; ++k) {
+                bool upper = corner & (1 << k);
+                cell[k] = lower[k] + (upper ? 1 : 0);
+                weight *= upper ? frac[k] : 1.0 - frac[k];
+            }
+            grid[cellIndex(cell)] += weight;
+        }
+    }
+
+    // potential = green * mass
+    fft.transformGrid(grid.data(), D, false);
+    for (size_t i = 0; i < grid.size(); ++i) {
+        grid[i] *= green[i];
+    }
+    fft.transformGrid(grid.data(), D, true);
+}
+
+template<int D>
+VecN<D> ParticleMeshN<D>::accelerationAt(const VecN<D>& pos) const {
+    int lower[D];
+    double frac[D];
+    locate(pos, lower, frac);
+
+    VecN<D> acc;
+    for (int corner = 0; corner < (1 << D); ++corner) {
+        int cell[D];
+        double weight = 1.0;
+        for (int k = 0; k < D; ++k) {
+            bool upper = corner & (1 << k);
+            cell[k] = lower[k] + (upper ? 1 : 0);
+            weight *= upper ? frac[k] : 1.0 - frac[k];
+        }
+
+        // a = -grad(phi), central differences
+        for (int k = 0; k < D; ++k) {
+            int ahead[D];
+            int behind[D];
+            for (int j = 0; j < D; ++j) {
+                ahead[j] = cell[j];
+                behind[j] = cell[j];
+            }
+            ++ahead[k];
+            --behind[k];
+            double gradient = (grid[cellIndex(ahead)].real() - grid[cellIndex(behind)].real()) / (2.0 * h);
+            acc[k] -= weight * gradient;
+        }
+    }
+    return acc;
+}
+
+template class ParticleMeshN<2>;
+template class ParticleMeshN<3>;
@@ -0,0 +1,76 @@
+//
+// Created by sailsec on 10/19/26.
+//
+
+#ifndef PARTICLEMESH_H
+#define PARTICLEMESH_H
+
+#include <complex>
+#include <vector>
+
+#include "Box.h"
+#include "FFT.h"
+#include "ParticleSpan.h"
+#include "Vec.h"
+
+// Long-range half of the TreePM force split.
+// Mass is deposited onto a regular mesh with cloud-in-cell weights, and the potential of the
+// Gaussian-smoothed (erf) part of 1/r is found by FFT convolution on a zero-padded 2N mesh, so
+// the boundaries are isolated like the tree's. The tree adds the complementary erfc part at
+// short range, within getCutoffRadius() of each particle.
+template<int D>
+class ParticleMeshN {
+
+private:
+    int cells;              // mesh cells per side covering the particles
+    int padded;             // 2 * cells, the FFT length per side
+    double split_cells;     // split radius r_s in units of the cell size
+    double cutoff_splits;   // short-range cutoff in units of r_s
+
+    double h = 0.0;         // cell size of the current solve
+    VecN<D> origin;         // corner of cell 0
+
+    std::vector<std::complex<double>> grid;  // mass, then potential, padded^D
+    std::vector<std::complex<double>> green; // transformed long-range Green's function
+    double green_h = 0.0;   // cell size green was built for
+    double green_G = 0.0;
+
+    FFT fft;
+
+    size_t cellIndex(const int (&cell)[D]) const {
+        size_t index = 0;
+        for (int k = 0; k < D; ++k) {
+            index = index * padded + static_cast<size_t>(cell[k]);
+        }
+        return index;
+    }
+
+    // Mesh coordinates of pos relative to cell centers: lower cell and offset toward the next one
+    void locate(const VecN<D>& pos, int (&lower)[D], double (&frac)[D]) const;
+
+    // Rebuilds the transformed Green's function for the spacing h
+    void buildGreen(double G);
+
+public:
+    // pre: mesh_cells is a power of two and at least 8
+    ParticleMeshN(int mesh_cells, double split_cells = 1.25, double cutoff_splits = 4.5);
+
+    double getSplitRadius() const {
+        return split_cells * h;
+    }
+    double getCutoffRadius() const {
+        return cutoff_splits * split_cells * h;
+    }
+
+    // Deposits particles onto the mesh covering bounds and solves for the long-range potential.
+    void solve(const ParticleSpanN<D>& particles, const BoxN<D>& bounds, double G);
+
+    // Long-range acceleration at pos from the last solve, interpolated with the deposit weights
+    VecN<D> accelerationAt(const VecN<D>& pos) const;
+};
+
+using ParticleMesh2 = ParticleMeshN<2>;
+using ParticleMesh3 = ParticleMeshN<3>;
+using ParticleMesh = ParticleMesh3; // the default 3D build
+
+#endif //PARTICLEMESH_H
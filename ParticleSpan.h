@@ -0,0 +1,62 @@
+//
+// Created by sailsec on 10/19/26.
+//
+
+#ifndef PARTICLESPAN_H
+#define PARTICLESPAN_H
+
+#include <cstddef>
+
+#include "Vec.h"
+
+// Non-owning, strided view of particle data: the layout the tree engine works on.
+// Each field is a base pointer plus a byte stride between consecutive particles, so the
+// same engine runs on BHtree's own Particle array and, without copying, on buffers owned
+// by an embedding application (array of structs, struct of arrays, or anything between).
+// A stride of 0 repeats the first record, e.g. one shared mass for every particle.
+template<int D>
+struct ParticleSpanN {
+    size_t count = 0;
+
+    double* pos = nullptr;        // D doubles per particle, read by build and force, written by integrate
+    size_t pos_stride = 0;
+    double* vel = nullptr;        // D doubles per particle, only needed by integrate
+    size_t vel_stride = 0;
+    double* acc = nullptr;        // D doubles per particle, written by the force pass
+    size_t acc_stride = 0;
+    const double* mass = nullptr; // one double per particle
+    size_t mass_stride = 0;
+
+    static double* at(double* base, size_t stride, size_t i) {
+        return reinterpret_cast<double*>(reinterpret_cast<char*>(base) + i * stride);
+    }
+    static const double* at(const double* base, size_t stride, size_t i) {
+        return reinterpret_cast<const double*>(reinterpret_cast<const char*>(base) + i * stride);
+    }
+
+    static VecN<D> load(const double* p) {
+        VecN<D> v;
+        for (int k = 0; k < D; ++k) v[k] = p[k];
+        return v;
+    }
+    static void store(double* p, const VecN<D>& v) {
+        for (int k = 0; k < D; ++k) p[k] = v[k];
+    }
+
+    // --- Getters ---
+    VecN<D> getPos(size_t i) const { return load(at(pos, pos_stride, i)); }
+    VecN<D> getVel(size_t i) const { return load(at(vel, vel_stride, i)); }
+    VecN<D> getAcc(size_t i) const { return load(at(acc, acc_stride, i)); }
+    double getMass(size_t i) const { return *at(mass, mass_stride, i); }
+
+    // --- Setters ---
+    void setPos(size_t i, const VecN<D>& v) const { store(at(pos, pos_stride, i), v); }
+    void setVel(size_t i, const VecN<D>& v) const { store(at(vel, vel_stride, i), v); }
+    void setAcc(size_t i, const VecN<D>& v) const { store(at(acc, acc_stride, i), v); }
+};
+
+using ParticleSpan2 = ParticleSpanN<2>;
+using ParticleSpan3 = ParticleSpanN<3>;
+using ParticleSpan = ParticleSpan3; // the default 3D build
+
+#endif //PARTICLESPAN_H
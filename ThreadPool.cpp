@@ -0,0 +1,240 @@
+//
+// Created by sailsec on 10/19/26.
+//
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+thread_local ThreadPool* ThreadPool::current_pool = nullptr;
+thread_local size_t ThreadPool::current_index = 0;
+
+ThreadPool::ThreadPool(size_t num_threads) {
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    workers.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+
+    // queues must all exist before any worker starts stealing
+    threads.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+        threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stopping = true;
+    }
+    sleep_cv.notify_all();
+    for (std::thread& t : threads) {
+        t.join();
+    }
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    current_pool = this;
+    current_index = index;
+
+    while (true) {
+        if (helpLoop()) {
+            continue;
+        }
+        Task task;
+        if (tryPop(task)) {
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        sleep_cv.wait(lock, [this] { return stopping || queued.load() > 0 || open_loop_count.load() > 0; });
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::tryPop(Task& task) {
+    const size_t n = workers.size();
+    const bool is_worker = (current_pool == this);
+    const size_t self = is_worker ? current_index : 0;
+
+    // own queue first, newest task
+    if (is_worker) {
+        Worker& own = *workers[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // steal the oldest task from the others
+    for (size_t k = is_worker ? 1 : 0; k < n; ++k) {
+        Worker& victim = *workers[(self + k) % n];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::push(Task task) {
+    // workers keep their own continuations local, outside threads spread round robin
+    size_t index = (current_pool == this) ? current_index
+                                          : next_queue.fetch_add(1) % workers.size();
+    {
+        std::lock_guard<std::mutex> lock(workers[index]->mutex);
+        workers[index]->tasks.push_back(std::move(task));
+    }
+    {
+        // publish under the sleep lock so an idle worker cannot miss the wakeup
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        queued.fetch_add(1);
+    }
+    sleep_cv.notify_one();
+}
+
+void ThreadPool::submit(TaskGroup& group, Task task) {
+    group.pending.fetch_add(1);
+    push([this, &group, task = std::move(task)] {
+        try {
+            task();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(group.error_mutex);
+            if (!group.error) {
+                group.error = std::current_exception();
+            }
+        }
+        // decrement last: continuations submitted by task are already counted
+        if (group.pending.fetch_sub(1) == 1) {
+            // the group is done: wake a caller blocked in wait(), without touching group again.
+            // Taking the lock orders this after the waiter's last check of pending.
+            { std::lock_guard<std::mutex> lock(sleep_mutex); }
+            sleep_cv.notify_all();
+        }
+    });
+}
+
+void ThreadPool::wait(TaskGroup& group) {
+    while (group.pending.load() > 0) {
+        Task task;
+        if (tryPop(task)) {
+            task();
+            continue;
+        }
+
+        // nothing to help with: sleep until more work is queued or the group finishes,
+        // rather than spinning next to the workers
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        sleep_cv.wait(lock, [this, &group] { return queued.load() > 0 || group.pending.load() == 0; });
+    }
+
+    std::lock_guard<std::mutex> lock(group.error_mutex);
+    if (group.error) {
+        std::exception_ptr error = group.error;
+        group.error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::runIterations(ParallelLoop& loop) {
+    while (true) {
+        size_t i = loop.next.fetch_add(1);
+        if (i >= loop.count) {
+            // every iteration is claimed, nobody else needs to join
+            unlinkLoop(loop);
+            return;
+        }
+        try {
+            loop.body(loop.context, i);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(loop.error_mutex);
+            if (!loop.error) {
+                loop.error = std::current_exception();
+            }
+        }
+    }
+}
+
+void ThreadPool::unlinkLoop(ParallelLoop& loop) {
+    std::lock_guard<std::mutex> lock(loops_mutex);
+    if (!loop.linked) {
+        return;
+    }
+    ParallelLoop** link = &open_loops;
+    while (*link != &loop) {
+        link = &(*link)->next_open;
+    }
+    *link = loop.next_open;
+    loop.linked = false;
+    open_loop_count.fetch_sub(1);
+}
+
+bool ThreadPool::helpLoop() {
+    ParallelLoop* loop;
+    {
+        // joining under the lock: once the caller has unlinked the loop, no helper can enter
+        std::lock_guard<std::mutex> lock(loops_mutex);
+        loop = open_loops;
+        if (loop == nullptr) {
+            return false;
+        }
+        loop->helpers.fetch_add(1);
+    }
+    runIterations(*loop);
+    if (loop->helpers.fetch_sub(1) == 1) {
+        // the loop may be gone from here on, only the pool is touched
+        { std::lock_guard<std::mutex> lock(sleep_mutex); }
+        sleep_cv.notify_all();
+    }
+    return true;
+}
+
+void ThreadPool::runLoop(ParallelLoop& loop, size_t count, void (*body)(const void*, size_t),
+                         const void* context) {
+    if (count == 0) {
+        return;
+    }
+    loop.body = body;
+    loop.context = context;
+    loop.count = count;
+    loop.next.store(0);
+    {
+        std::lock_guard<std::mutex> lock(loops_mutex);
+        loop.next_open = open_loops;
+        open_loops = &loop;
+        loop.linked = true;
+    }
+    {
+        // publish under the sleep lock so an idle worker cannot miss the wakeup
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        open_loop_count.fetch_add(1);
+    }
+    sleep_cv.notify_all();
+
+    // the caller works too, then waits for the helpers still finishing their last iteration
+    runIterations(loop);
+    {
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        sleep_cv.wait(lock, [&loop] { return loop.helpers.load() == 0; });
+    }
+
+    std::lock_guard<std::mutex> lock(loop.error_mutex);
+    if (loop.error) {
+        std::exception_ptr error = loop.error;
+        loop.error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
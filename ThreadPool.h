@@ -0,0 +1,132 @@
+//
+// Created by sailsec on 10/19/26.
+//
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Tracks a set of tasks submitted to a ThreadPool so the caller can wait for all of them.
+// Tasks may submit more tasks into the same group (continuations); the group is
+// done only when every task, including those, has finished.
+class TaskGroup {
+private:
+    friend class ThreadPool;
+
+    std::atomic<size_t> pending{0};  // submitted but not yet finished
+    std::mutex error_mutex;
+    std::exception_ptr error;        // first exception thrown by a task, rethrown by wait()
+};
+
+// State of one ThreadPool::parallelFor, owned by the caller and reused across loops so that
+// running a loop never allocates. One loop at a time per ParallelLoop.
+class ParallelLoop {
+private:
+    friend class ThreadPool;
+
+    void (*body)(const void* context, size_t i) = nullptr;
+    const void* context = nullptr;
+    size_t count = 0;
+
+    std::atomic<size_t> next{0};        // next iteration to claim
+    std::atomic<int> helpers{0};        // workers inside the loop, the caller waits for 0
+    bool linked = false;                // guarded by the pool's loops_mutex
+    ParallelLoop* next_open = nullptr;  // intrusive list of the pool's open loops
+
+    std::mutex error_mutex;
+    std::exception_ptr error;           // first exception thrown by body, rethrown by parallelFor
+};
+
+// Work-stealing thread pool
+// each worker owns a deque: it pushes and pops its own work at the back (LIFO, cache-warm)
+// and idle workers steal from the front of the others (FIFO, oldest and largest work first)
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers; // one queue per thread
+    std::vector<std::thread> threads;
+
+    std::mutex sleep_mutex;              // guards the idle waits of workers and wait() callers
+    std::condition_variable sleep_cv;
+    std::atomic<long> queued{0};         // tasks sitting in any queue (may dip below 0 between push and publish)
+    std::atomic<size_t> next_queue{0};   // round robin for submissions from outside the pool
+    bool stopping = false;               // guarded by sleep_mutex
+
+    std::mutex loops_mutex;              // guards the open loop list
+    ParallelLoop* open_loops = nullptr;  // loops idle workers may join, newest first
+    std::atomic<long> open_loop_count{0};
+
+    // identifies the pool worker running on the current thread, if any
+    static thread_local ThreadPool* current_pool;
+    static thread_local size_t current_index;
+
+    void workerLoop(size_t index);
+
+    // Pops from the caller's own queue, or steals from another one.
+    // post: returns false if every queue was empty
+    bool tryPop(Task& task);
+
+    void push(Task task);
+
+    // Claims and runs iterations of loop until none are left, then closes it to new helpers
+    void runIterations(ParallelLoop& loop);
+    void unlinkLoop(ParallelLoop& loop);
+
+    // Joins the newest open loop, if any.
+    // post: returns false if no loop was open
+    bool helpLoop();
+
+    void runLoop(ParallelLoop& loop, size_t count, void (*body)(const void*, size_t), const void* context);
+
+public:
+    // Starts num_threads workers, 0 means one per hardware thread
+    explicit ThreadPool(size_t num_threads = 0);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Joins all workers. Tasks still queued are dropped, so wait() on groups first.
+    ~ThreadPool();
+
+    size_t getThreadCount() const {
+        return threads.size();
+    }
+
+    // Queues task as part of group. Safe to call from inside a running task.
+    void submit(TaskGroup& group, Task task);
+
+    // Blocks until every task in group has finished, running queued tasks meanwhile
+    // so that waiting from inside a task cannot deadlock the pool. Sleeps while there is
+    // nothing to run.
+    // post: rethrows the first exception raised by a task of the group
+    void wait(TaskGroup& group);
+
+    // Runs body(i) for every i in [0, count) on the calling thread and any idle workers, and
+    // returns once all have finished. Iterations are claimed from an atomic counter, and all
+    // state lives in loop, so unlike submit this does not allocate.
+    // post: rethrows the first exception raised by body
+    template<typename Body>
+    void parallelFor(ParallelLoop& loop, size_t count, const Body& body) {
+        runLoop(loop, count, [](const void* context, size_t i) {
+            (*static_cast<const Body*>(context))(i);
+        }, &body);
+    }
+};
+
+#endif //THREADPOOL_H
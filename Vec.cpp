@@ -4,26 +4,6 @@
 
 #include "Vec.h"
 
-#include <stdexcept>
-
-// Vec operator+(const Vec& rhs) const;
-// Vec operator-(const Vec& rhs) const;
-// Vec operator*(double rhs) const;
-// Vec operator/(double rhs) const;
-
-Vec Vec::operator+(const Vec& rhs) const {
-    return Vec(x+rhs.x, y+rhs.y, z+rhs.z);
-};
-Vec Vec::operator-(const Vec& rhs) const {
-    return Vec(x-rhs.x, y-rhs.y, z-rhs.z);
-};
-
-Vec Vec::operator*(double rhs) const {
-    return Vec(x*rhs, y*rhs, z*rhs);
-};
-Vec Vec::operator/(double rhs) const {
-    if (rhs == 0.0) {
-        throw std::invalid_argument("Division by 0");
-    }
-    return Vec(x/rhs, y/rhs, z/rhs);
-};
\ No newline at end of file
+// the supported dimensions, compiled once here so both stay building
+template struct VecN<2>;
+template struct VecN<3>;
@@ -5,33 +5,84 @@
 #ifndef VEC_H
 #define VEC_H
 
-// 3d Vector struct
+#include <cmath>
+#include <stdexcept>
+
+// D-dimensional vector struct, D = 2 (quadtree builds) or D = 3 (octree builds)
 // instantiated explicitly in: particle
 // stack allocated
 // only allow explicit declaration
+// the arithmetic is defined here so the compiler can unroll it for the fixed D
+
+template<int D>
+struct VecN {
+    static_assert(D == 2 || D == 3, "VecN supports 2D and 3D only");
 
-struct Vec {
-    double x, y, z;
-    Vec(double x, double y, double z) : x(x), y(y), z(z) {}
-    Vec() : x(0), y(0), z(0) {}
+    double c[D]; // components, c[0] = x, c[1] = y, c[2] = z
 
+    VecN() : c{} {}
+    template<typename... Coords>
+        requires (sizeof...(Coords) == D)
+    VecN(Coords... coords) : c{static_cast<double>(coords)...} {}
 
+    double& operator[](int i) { return c[i]; }
+    double operator[](int i) const { return c[i]; }
 
+    // named components, the old Vec::x/y/z fields; z() only exists for D = 3
+    double& x() { return c[0]; }
+    double x() const { return c[0]; }
+    double& y() { return c[1]; }
+    double y() const { return c[1]; }
+    double& z() requires (D >= 3) { return c[2]; }
+    double z() const requires (D >= 3) { return c[2]; }
 
-    double magnitude() const;
-    double magnitude_sq() const;
-    void dot(Vec &other) const;
-    Vec normalized();
+    double magnitude() const {
+        return std::sqrt(magnitude_sq());
+    }
+    double magnitude_sq() const {
+        return dot(*this);
+    }
+    double dot(const VecN& other) const {
+        double sum = 0.0;
+        for (int i = 0; i < D; ++i) {
+            sum += c[i] * other.c[i];
+        }
+        return sum;
+    }
+    VecN normalized() const {
+        return *this / magnitude();
+    }
 
     // vector operations
 
-    Vec operator+(const Vec& rhs) const;
-    Vec operator-(const Vec& rhs) const;
-    Vec operator*(double rhs) const;
-    Vec operator/(double rhs) const;
+    VecN operator+(const VecN& rhs) const {
+        VecN out;
+        for (int i = 0; i < D; ++i) out.c[i] = c[i] + rhs.c[i];
+        return out;
+    }
+    VecN operator-(const VecN& rhs) const {
+        VecN out;
+        for (int i = 0; i < D; ++i) out.c[i] = c[i] - rhs.c[i];
+        return out;
+    }
+    VecN operator*(double rhs) const {
+        VecN out;
+        for (int i = 0; i < D; ++i) out.c[i] = c[i] * rhs;
+        return out;
+    }
+    VecN operator/(double rhs) const {
+        if (rhs == 0.0) {
+            throw std::invalid_argument("Division by 0");
+        }
+        VecN out;
+        for (int i = 0; i < D; ++i) out.c[i] = c[i] / rhs;
+        return out;
+    }
 
 };
 
-
+using Vec2 = VecN<2>;
+using Vec3 = VecN<3>;
+using Vec = Vec3; // the default 3D build
 
 #endif //VEC_H
@@ -0,0 +1,144 @@
+//
+// Created by sailsec on 10/19/26.
+//
+
+// Checks the tree and TreePM accelerations against direct summation, in 2D and 3D.
+// A random cloud must match within a relative RMS tolerance per solver, and a two-body pair
+// must attract each other with the magnitude G * m / r^2. Runs every case and exits non-zero
+// if any of them fails.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BHtree.h"
+
+namespace {
+
+constexpr size_t NUM_PARTICLES = 4000;
+constexpr double THETA = 0.5;
+constexpr double G = 1.0;
+// relative RMS error against direct summation
+constexpr double TREE_TOLERANCE = 0.01;
+constexpr double TREE_PM_TOLERANCE = 0.02;
+// relative error of each acceleration in the two-body case
+constexpr double PAIR_TOLERANCE = 0.02;
+
+struct Solver {
+    std::string name;
+    int mesh_cells;  // 0 runs the plain tree
+    double tolerance;
+};
+
+template<int D>
+void configure(BHtreeN<D>& tree, const Solver& solver) {
+    tree.setGravitationalConstant(G);
+    if (solver.mesh_cells > 0) {
+        tree.enableTreePM(solver.mesh_cells);
+    }
+    tree.buildTree();
+    tree.calculateForces(THETA);
+}
+
+template<int D>
+bool report(bool ok, const Solver& solver, const std::string& what, double error, double tolerance) {
+    std::ostream& out = ok ? std::cout : std::cerr;
+    out << (ok ? "ok   " : "FAIL ") << D << "D " << solver.name << " " << what << ": relative error "
+        << error << " (tolerance " << tolerance << ")" << std::endl;
+    return ok;
+}
+
+// a uniform cloud, compared particle by particle with direct summation
+template<int D>
+bool checkCloud(const Solver& solver) {
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<> dist(0.0, 1.0);
+    std::vector<ParticleN<D>> particles;
+    particles.reserve(NUM_PARTICLES);
+    for (size_t i = 0; i < NUM_PARTICLES; ++i) {
+        VecN<D> pos;
+        for (int k = 0; k < D; ++k) {
+            pos[k] = dist(gen);
+        }
+        particles.emplace_back(pos, VecN<D>(), VecN<D>(), 1.0 / NUM_PARTICLES, static_cast<int>(i));
+    }
+
+    std::vector<VecN<D>> expected(NUM_PARTICLES);
+    for (size_t i = 0; i < NUM_PARTICLES; ++i) {
+        for (size_t j = 0; j < NUM_PARTICLES; ++j) {
+            if (j != i) {
+                const VecN<D> r = particles[j].getPos() - particles[i].getPos();
+                const double dist_sq = r.magnitude_sq();
+                expected[i] = expected[i] + r * (G * particles[j].getMass() / (dist_sq * std::sqrt(dist_sq)));
+            }
+        }
+    }
+
+    BHtreeN<D> tree(particles);
+    configure(tree, solver);
+    double diff_sq = 0.0;
+    double norm_sq = 0.0;
+    for (size_t slot = 0; slot < tree.size(); ++slot) {
+        const VecN<D>& a = expected[tree.getOriginalIndex(slot)];
+        diff_sq += (tree.getSpan().getAcc(slot) - a).magnitude_sq();
+        norm_sq += a.magnitude_sq();
+    }
+    const double error = std::sqrt(diff_sq / norm_sq);
+    return report<D>(error <= solver.tolerance, solver, "cloud", error, solver.tolerance);
+}
+
+// two unequal masses on the first axis: each is pulled towards the other by G * m_other / r^2
+template<int D>
+bool checkPair(const Solver& solver) {
+    const double masses[2] = {2.0, 3.0};
+    const double separation = 1.5;
+    VecN<D> left;
+    VecN<D> right;
+    right[0] = separation;
+    std::vector<ParticleN<D>> particles;
+    particles.emplace_back(left, VecN<D>(), VecN<D>(), masses[0], 0);
+    particles.emplace_back(right, VecN<D>(), VecN<D>(), masses[1], 1);
+
+    BHtreeN<D> tree(particles);
+    configure(tree, solver);
+    double error = 0.0;
+    bool attractive = true;
+    for (size_t slot = 0; slot < tree.size(); ++slot) {
+        const size_t id = tree.getOriginalIndex(slot);
+        // towards the other particle: +x for the left one, -x for the right one
+        const double direction = id == 0 ? 1.0 : -1.0;
+        const double expected = G * masses[1 - id] / (separation * separation);
+        const VecN<D> a = tree.getSpan().getAcc(slot);
+        attractive = attractive && a[0] * direction > 0.0;
+        VecN<D> diff = a;
+        diff[0] -= direction * expected;
+        error = std::max(error, diff.magnitude() / expected);
+    }
+    if (!attractive) {
+        std::cerr << "FAIL " << D << "D " << solver.name << " pair: accelerations point apart" << std::endl;
+        return false;
+    }
+    return report<D>(error <= PAIR_TOLERANCE, solver, "pair", error, PAIR_TOLERANCE);
+}
+
+} // namespace
+
+int main() {
+    const Solver solvers[] = {
+        {"tree", 0, TREE_TOLERANCE},
+        {"TreePM", 32, TREE_PM_TOLERANCE},
+    };
+
+    bool ok = true;
+    for (const Solver& solver : solvers) {
+        ok = checkCloud<2>(solver) && ok;
+        ok = checkCloud<3>(solver) && ok;
+        ok = checkPair<2>(solver) && ok;
+        ok = checkPair<3>(solver) && ok;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
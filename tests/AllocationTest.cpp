@@ -0,0 +1,184 @@
+//
+// Created by sailsec on 10/19/26.
+//
+
+// Checks that steady-state steps do not touch the heap.
+// Every global operator new is replaced by a counting one. Each configuration runs one
+// warm-up step, then buildTree, calculateForces and step must all complete without a
+// single allocation. Runs and reports every configuration, and exits non-zero if any of
+// them allocated.
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BHtree.h"
+#include "ThreadPool.h"
+
+namespace {
+
+std::atomic<bool> counting{false};
+std::atomic<long> allocations{0};
+
+void* countedAlloc(size_t size) {
+    if (counting.load(std::memory_order_relaxed)) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* countedAlignedAlloc(size_t size, std::align_val_t align) {
+    if (counting.load(std::memory_order_relaxed)) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    size_t alignment = static_cast<size_t>(align);
+    size_t rounded = (std::max<size_t>(size, 1) + alignment - 1) / alignment * alignment;
+    if (void* p = std::aligned_alloc(alignment, rounded)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+void* operator new(size_t size) { return countedAlloc(size); }
+void* operator new[](size_t size) { return countedAlloc(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try { return countedAlloc(size); } catch (...) { return nullptr; }
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    try { return countedAlloc(size); } catch (...) { return nullptr; }
+}
+void* operator new(size_t size, std::align_val_t align) { return countedAlignedAlloc(size, align); }
+void* operator new[](size_t size, std::align_val_t align) { return countedAlignedAlloc(size, align); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+
+namespace {
+
+constexpr size_t NUM_PARTICLES = 4000;
+// enough for the bounds and integration sweeps to split into several chunks as well
+constexpr size_t NUM_PARTICLES_POOLED = 40000;
+constexpr double DT = 1e-3;
+constexpr double THETA = 0.5;
+
+struct Config {
+    std::string name;
+    bool tree_pm;
+    bool caching;
+    size_t threads;  // 0 runs serially, otherwise the sweeps run on a pool of this size
+    size_t particles;
+};
+
+template<int D>
+std::vector<ParticleN<D>> makeParticles(size_t count) {
+    std::mt19937 gen(7);
+    std::normal_distribution<> dist(0.0, 1.0);
+    std::vector<ParticleN<D>> particles;
+    particles.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        VecN<D> pos;
+        VecN<D> vel;
+        for (int k = 0; k < D; ++k) {
+            pos[k] = dist(gen);
+            vel[k] = 0.01 * dist(gen);
+        }
+        particles.emplace_back(pos, vel, VecN<D>(), 1.0 / count, static_cast<int>(i));
+    }
+    return particles;
+}
+
+// post: number of allocations made by op, which runs with counting enabled
+template<typename Op>
+long countAllocations(Op&& op) {
+    allocations.store(0);
+    counting.store(true);
+    op();
+    counting.store(false);
+    return allocations.load();
+}
+
+template<int D>
+bool runConfig(const Config& config) {
+    // the pool outlives the tree using it
+    std::unique_ptr<ThreadPool> pool;
+    if (config.threads > 0) {
+        pool = std::make_unique<ThreadPool>(config.threads);
+    }
+
+    BHtreeN<D> tree(makeParticles<D>(config.particles));
+    tree.setThreadPool(pool.get());
+    tree.setGravitationalConstant(1.0);
+    tree.setReorderInterval(3);
+    if (config.tree_pm) {
+        tree.enableTreePM(16);
+    }
+    if (config.caching) {
+        tree.enableInteractionCaching();
+    }
+
+    // warm-up: the node pool, mesh and scratch buffers reach their working size
+    tree.step(DT, THETA);
+
+    struct Phase {
+        const char* name;
+        long count;
+    };
+    const Phase phases[] = {
+        {"buildTree", countAllocations([&] { tree.buildTree(); })},
+        {"calculateForces", countAllocations([&] { tree.calculateForces(THETA); })},
+        {"step", countAllocations([&] {
+            for (int s = 0; s < 4; ++s) {
+                tree.step(DT, THETA);
+            }
+        })},
+    };
+
+    bool ok = true;
+    for (const Phase& phase : phases) {
+        if (phase.count != 0) {
+            std::cerr << "FAIL " << D << "D " << config.name << ": " << phase.name << " made "
+                      << phase.count << " allocations" << std::endl;
+            ok = false;
+        }
+    }
+    if (ok) {
+        std::cout << "ok   " << D << "D " << config.name << std::endl;
+    }
+    return ok;
+}
+
+} // namespace
+
+int main() {
+    const Config configs[] = {
+        {"tree", false, false, 0, NUM_PARTICLES},
+        {"TreePM", true, false, 0, NUM_PARTICLES},
+        {"tree + interaction caching", false, true, 0, NUM_PARTICLES},
+        {"TreePM + interaction caching", true, true, 0, NUM_PARTICLES},
+        {"tree, 4-thread pool", false, false, 4, NUM_PARTICLES_POOLED},
+        {"TreePM + interaction caching, 4-thread pool", true, true, 4, NUM_PARTICLES},
+    };
+
+    bool ok = true;
+    for (const Config& config : configs) {
+        ok = runConfig<2>(config) && ok;
+        ok = runConfig<3>(config) && ok;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
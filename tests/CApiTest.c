@@ -0,0 +1,156 @@
+/*
+ * Created by sailsec on 10/19/26.
+ *
+ * Exercises the bhtree C interface from plain C, the way an embedding program would.
+ * Particles live in the caller's array of structs, and every field is registered with
+ * the struct size as its stride. All particles share one mass, passed with stride 0.
+ * Runs every case and exits non-zero if any of them fails.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "BHtreeCApi.h"
+
+#define NUM_PARTICLES 2000
+#define THETA 0.5
+/* relative RMS difference between tree and direct-sum accelerations */
+#define FORCE_TOLERANCE 0.01
+
+/* the caller's own record, with fields the library never touches */
+typedef struct {
+    double pos[3];
+    double vel[3];
+    double acc[3];
+    int tag;
+} Body;
+
+static int failures = 0;
+
+static void check(int ok, int dimensions, const char* what, const bh_tree* tree) {
+    if (ok) {
+        printf("ok   %dD %s\n", dimensions, what);
+    } else {
+        fprintf(stderr, "FAIL %dD %s", dimensions, what);
+        if (tree != NULL) {
+            fprintf(stderr, " (last error: \"%s\")", bh_last_error(tree));
+        }
+        fprintf(stderr, "\n");
+        ++failures;
+    }
+}
+
+static void makeBodies(Body* bodies, size_t count) {
+    size_t i;
+    int k;
+    srand(3);
+    memset(bodies, 0, count * sizeof(Body));
+    for (i = 0; i < count; ++i) {
+        for (k = 0; k < 3; ++k) {
+            bodies[i].pos[k] = rand() / (double) RAND_MAX;
+        }
+        bodies[i].tag = (int) i;
+    }
+}
+
+/* relative RMS difference between the accelerations in bodies and direct summation */
+static double directSumError(const Body* bodies, size_t count, int dimensions, double g, double mass) {
+    double diff_sq = 0.0;
+    double norm_sq = 0.0;
+    size_t i, j;
+    int k;
+    for (i = 0; i < count; ++i) {
+        double acc[3] = {0.0, 0.0, 0.0};
+        for (j = 0; j < count; ++j) {
+            double r[3];
+            double dist_sq = 0.0;
+            double f;
+            if (j == i) {
+                continue;
+            }
+            for (k = 0; k < dimensions; ++k) {
+                r[k] = bodies[j].pos[k] - bodies[i].pos[k];
+                dist_sq += r[k] * r[k];
+            }
+            f = g * mass / (dist_sq * sqrt(dist_sq));
+            for (k = 0; k < dimensions; ++k) {
+                acc[k] += f * r[k];
+            }
+        }
+        for (k = 0; k < dimensions; ++k) {
+            double d = bodies[i].acc[k] - acc[k];
+            diff_sq += d * d;
+            norm_sq += acc[k] * acc[k];
+        }
+    }
+    return sqrt(diff_sq / norm_sq);
+}
+
+static void runCases(int dimensions) {
+    const double mass = 1.0 / NUM_PARTICLES;
+    const size_t stride = sizeof(Body);
+    Body* bodies = malloc(NUM_PARTICLES * sizeof(Body));
+    bh_tree* tree = bh_create(dimensions);
+    double error;
+    int tags_intact = 1;
+    size_t i;
+
+    if (bodies == NULL || tree == NULL) {
+        check(0, dimensions, "bh_create", NULL);
+        free(bodies);
+        bh_destroy(tree);
+        return;
+    }
+    makeBodies(bodies, NUM_PARTICLES);
+
+    /* array of structs, one shared mass */
+    check(bh_set_particles(tree, NUM_PARTICLES, bodies[0].pos, stride, &mass, 0,
+                           bodies[0].acc, stride) == BH_OK,
+          dimensions, "bh_set_particles on an array of structs, mass stride 0", tree);
+    check(bh_set_gravitational_constant(tree, 1.0) == BH_OK, dimensions, "bh_set_gravitational_constant", tree);
+
+    /* forces against direct summation */
+    check(bh_build(tree) == BH_OK, dimensions, "bh_build", tree);
+    check(bh_forces(tree, THETA) == BH_OK, dimensions, "bh_forces", tree);
+    error = directSumError(bodies, NUM_PARTICLES, dimensions, 1.0, mass);
+    check(error < FORCE_TOLERANCE, dimensions, "bh_forces matches direct summation", NULL);
+    printf("     relative RMS error %.2e (tolerance %.0e)\n", error, FORCE_TOLERANCE);
+    for (i = 0; i < NUM_PARTICLES; ++i) {
+        tags_intact = tags_intact && bodies[i].tag == (int) i;
+    }
+    check(tags_intact, dimensions, "fields outside the registered ones are untouched", NULL);
+
+    /* stepping needs velocities */
+    check(bh_step(tree, 1e-3, THETA) == BH_ERROR_STATE, dimensions, "bh_step without velocities", NULL);
+    check(bh_set_velocities(tree, bodies[0].vel, stride) == BH_OK, dimensions, "bh_set_velocities", tree);
+    check(bh_step(tree, 1e-3, THETA) == BH_OK, dimensions, "bh_step", tree);
+
+    /* records narrower than a vector would overlap */
+    check(bh_set_particles(tree, NUM_PARTICLES, bodies[0].pos, (dimensions - 1) * sizeof(double), &mass, 0,
+                           bodies[0].acc, stride) == BH_ERROR_INVALID_ARGUMENT,
+          dimensions, "position stride below dimensions * sizeof(double)", NULL);
+    check(bh_set_particles(tree, NUM_PARTICLES, bodies[0].pos, stride, &mass, 0,
+                           bodies[0].acc, (dimensions - 1) * sizeof(double)) == BH_ERROR_INVALID_ARGUMENT,
+          dimensions, "acceleration stride below dimensions * sizeof(double)", NULL);
+
+    /* coincident particles fail the build, and leave no tree to compute forces with */
+    memcpy(bodies[1].pos, bodies[0].pos, sizeof(bodies[0].pos));
+    check(bh_set_particles(tree, NUM_PARTICLES, bodies[0].pos, stride, &mass, 0,
+                           bodies[0].acc, stride) == BH_OK,
+          dimensions, "bh_set_particles with coincident particles", tree);
+    check(bh_build(tree) == BH_ERROR_RUNTIME, dimensions, "bh_build on coincident particles", NULL);
+    check(bh_last_error(tree)[0] != '\0', dimensions, "bh_last_error explains the failed build", NULL);
+    check(bh_forces(tree, THETA) == BH_ERROR_STATE, dimensions, "bh_forces after a failed build", NULL);
+
+    bh_destroy(tree);
+    free(bodies);
+}
+
+int main(void) {
+    runCases(2);
+    runCases(3);
+    check(bh_create(4) == NULL, 4, "bh_create rejects unsupported dimensions", NULL);
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,114 @@
+//
+// Created by sailsec on 10/19/26.
+//
+
+// Checks that an ensemble run gives the same result as stepping each member on its own.
+// Two members of different sizes run a few steps on a shared 4-thread pool. Their positions
+// and velocities must be bitwise equal to a serial step() loop on the same input, and the
+// run's step counts must add up. Runs in 2D and 3D and exits non-zero if either fails.
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include "BHtree.h"
+#include "Ensemble.h"
+
+namespace {
+
+constexpr int NUM_STEPS = 5;
+constexpr double DT = 1e-3;
+constexpr double THETA = 0.5;
+// the larger member spans several force chunks
+const size_t MEMBER_SIZES[] = {1500, 3 * BHtreeN<3>::FORCE_CHUNK + 100};
+
+template<int D>
+std::vector<ParticleN<D>> makeParticles(size_t count, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::normal_distribution<> dist(0.0, 1.0);
+    std::vector<ParticleN<D>> particles;
+    particles.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        VecN<D> pos;
+        VecN<D> vel;
+        for (int k = 0; k < D; ++k) {
+            pos[k] = dist(gen);
+            vel[k] = 0.01 * dist(gen);
+        }
+        particles.emplace_back(pos, vel, VecN<D>(), 1.0 / count, static_cast<int>(i));
+    }
+    return particles;
+}
+
+bool sameBits(const void* a, const void* b, size_t size) {
+    return std::memcmp(a, b, size) == 0;
+}
+
+template<int D>
+bool runEnsemble() {
+    EnsembleN<D> ensemble(4);
+    std::vector<BHtreeN<D>> serial;
+    serial.reserve(std::size(MEMBER_SIZES));
+    long expected_particle_steps = 0;
+    unsigned seed = 1;
+    for (size_t n : MEMBER_SIZES) {
+        ensemble.addSimulation(makeParticles<D>(n, seed));
+        ensemble.getSimulation(ensemble.size() - 1).setGravitationalConstant(1.0);
+        serial.emplace_back(makeParticles<D>(n, seed));
+        serial.back().setGravitationalConstant(1.0);
+        expected_particle_steps += static_cast<long>(n) * NUM_STEPS;
+        ++seed;
+    }
+
+    const EnsembleStats stats = ensemble.run(NUM_STEPS, DT, THETA);
+    for (BHtreeN<D>& tree : serial) {
+        for (int s = 0; s < NUM_STEPS; ++s) {
+            tree.step(DT, THETA);
+        }
+    }
+
+    bool ok = true;
+    for (size_t m = 0; m < serial.size(); ++m) {
+        const ParticleSpanN<D>& got = ensemble.getSimulation(m).getSpan();
+        const ParticleSpanN<D>& want = serial[m].getSpan();
+        size_t mismatches = 0;
+        for (size_t i = 0; i < want.count; ++i) {
+            const VecN<D> got_pos = got.getPos(i);
+            const VecN<D> want_pos = want.getPos(i);
+            const VecN<D> got_vel = got.getVel(i);
+            const VecN<D> want_vel = want.getVel(i);
+            if (!sameBits(&got_pos, &want_pos, sizeof(want_pos)) || !sameBits(&got_vel, &want_vel, sizeof(want_vel))) {
+                ++mismatches;
+            }
+        }
+        if (mismatches != 0) {
+            std::cerr << "FAIL " << D << "D member " << m << ": " << mismatches << " of " << want.count
+                      << " particles differ from the serial run" << std::endl;
+            ok = false;
+        }
+    }
+    if (stats.particle_steps != expected_particle_steps
+        || stats.simulation_steps != static_cast<long>(serial.size()) * NUM_STEPS) {
+        std::cerr << "FAIL " << D << "D stats: " << stats.particle_steps << " particle steps, "
+                  << stats.simulation_steps << " simulation steps, expected " << expected_particle_steps
+                  << " and " << serial.size() * NUM_STEPS << std::endl;
+        ok = false;
+    }
+    if (ok) {
+        std::cout << "ok   " << D << "D " << serial.size() << " members match the serial run, "
+                  << stats.particle_steps << " particle steps" << std::endl;
+    }
+    return ok;
+}
+
+} // namespace
+
+int main() {
+    bool ok = true;
+    ok = runEnsemble<2>() && ok;
+    ok = runEnsemble<3>() && ok;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
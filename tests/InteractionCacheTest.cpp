@@ -0,0 +1,138 @@
+//
+// Created by sailsec on 10/19/26.
+//
+
+// Checks that interaction caching stays accurate while it refits instead of rebuilding.
+// Particles drift a little more each step; updateTree + calculateForces on the caching tree are
+// compared against a fresh uncached tree walk at the same positions after every step. The early
+// steps stay within the drift margins and refit, the later ones must outgrow them and rebuild.
+// Runs plain and TreePM, in 2D and 3D, and exits non-zero if any configuration is off.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "BHtree.h"
+
+namespace {
+
+constexpr size_t NUM_PARTICLES = 4000;
+constexpr int NUM_STEPS = 14;
+constexpr double THETA = 0.5;
+// per-step drift per axis against a unit spread of positions, doubling every step
+constexpr double DRIFT = 1e-6;
+// relative RMS difference of the accelerations, cached against a fresh walk
+constexpr double TOLERANCE = 0.01;
+
+template<int D>
+std::vector<ParticleN<D>> makeParticles(size_t count) {
+    std::mt19937 gen(11);
+    std::normal_distribution<> dist(0.0, 1.0);
+    std::vector<ParticleN<D>> particles;
+    particles.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        VecN<D> pos;
+        for (int k = 0; k < D; ++k) {
+            pos[k] = dist(gen);
+        }
+        particles.emplace_back(pos, VecN<D>(), VecN<D>(), 1.0 / count, static_cast<int>(i));
+    }
+    return particles;
+}
+
+// post: a tree over a copy of the positions and masses in tree, slot for slot
+template<int D>
+BHtreeN<D> snapshot(const BHtreeN<D>& tree) {
+    const ParticleSpanN<D>& span = tree.getSpan();
+    std::vector<ParticleN<D>> particles;
+    particles.reserve(span.count);
+    for (size_t i = 0; i < span.count; ++i) {
+        particles.emplace_back(span.getPos(i), VecN<D>(), VecN<D>(), span.getMass(i), static_cast<int>(i));
+    }
+    return BHtreeN<D>(particles);
+}
+
+template<int D>
+bool runConfig(bool tree_pm) {
+    const char* name = tree_pm ? "TreePM" : "tree";
+
+    BHtreeN<D> tree(makeParticles<D>(NUM_PARTICLES));
+    tree.setGravitationalConstant(1.0);
+    if (tree_pm) {
+        tree.enableTreePM(16);
+    }
+    tree.enableInteractionCaching();
+
+    std::mt19937 gen(5);
+    std::normal_distribution<> dist(0.0, DRIFT);
+    std::vector<VecN<D>> drift(tree.size());
+    for (VecN<D>& d : drift) {
+        for (int k = 0; k < D; ++k) {
+            d[k] = dist(gen);
+        }
+    }
+
+    // first build and lists
+    tree.updateTree(THETA);
+    const long initial_builds = tree.getBuildCount();
+
+    double worst = 0.0;
+    for (int s = 0; s < NUM_STEPS; ++s) {
+        const ParticleSpanN<D>& span = tree.getSpan();
+        for (size_t i = 0; i < span.count; ++i) {
+            span.setPos(i, span.getPos(i) + drift[i] * std::ldexp(1.0, s));
+        }
+        tree.updateTree(THETA);
+        tree.calculateForces(THETA);
+
+        BHtreeN<D> reference = snapshot(tree);
+        reference.setGravitationalConstant(1.0);
+        if (tree_pm) {
+            reference.enableTreePM(16);
+        }
+        reference.buildTree();
+        reference.calculateForces(THETA);
+
+        double diff_sq = 0.0;
+        double norm_sq = 0.0;
+        for (size_t i = 0; i < span.count; ++i) {
+            const VecN<D> expected = reference.getSpan().getAcc(i);
+            diff_sq += (span.getAcc(i) - expected).magnitude_sq();
+            norm_sq += expected.magnitude_sq();
+        }
+        worst = std::max(worst, std::sqrt(diff_sq / norm_sq));
+    }
+    const long rebuilds = tree.getBuildCount() - initial_builds;
+
+    bool ok = true;
+    if (worst > TOLERANCE) {
+        std::cerr << "FAIL " << D << "D " << name << ": relative RMS difference " << worst
+                  << " exceeds " << TOLERANCE << std::endl;
+        ok = false;
+    }
+    // both paths must have run: refits while the drift is small, rebuilds once it is not
+    if (rebuilds == 0 || rebuilds == NUM_STEPS) {
+        std::cerr << "FAIL " << D << "D " << name << ": rebuilt on " << rebuilds << " of "
+                  << NUM_STEPS << " steps" << std::endl;
+        ok = false;
+    }
+    if (ok) {
+        std::cout << "ok   " << D << "D " << name << ": relative RMS difference " << worst << ", "
+                  << NUM_STEPS - rebuilds << " of " << NUM_STEPS << " steps refit" << std::endl;
+    }
+    return ok;
+}
+
+} // namespace
+
+int main() {
+    bool ok = true;
+    for (bool tree_pm : {false, true}) {
+        ok = runConfig<2>(tree_pm) && ok;
+        ok = runConfig<3>(tree_pm) && ok;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}